@@ -23,8 +23,10 @@
 
 #include "TreeLib.h"
 #include "Parse.h"
+#include "nodeiterator.h"
 
 #include <vector>
+#include <unordered_map>
 
 
 // Convert a string to a NEXUS format string
@@ -260,6 +262,100 @@ NodePtr Tree::CopyOfSubtree (NodePtr RootedAt)
 }
 
 
+//------------------------------------------------------------------------------
+void Tree::MakeInducedSubtree (const Tree &t, const std::vector<NodePtr> &leaves)
+{
+	Name 			= t.GetName ();
+	InternalLabels 	= t.GetHasInternalLabels ();
+	EdgeLengths 	= t.GetHasEdgeLengths ();
+	Rooted 			= t.IsRooted();
+	Weight			= t.GetWeight();
+	Leaves 			= 0;
+	Internals 		= 0;
+	Root			= NULL;
+	if (leaves.empty())
+		return;
+
+	// Find the union of the paths from the leaves to the root. kept holds
+	// the nodes on these paths, and children[k] the positions in kept of
+	// the children of kept[k] that are on a path. As the leaves are visited
+	// from left to right, the children are listed from left to right. t is
+	// shared by threads restricting it at the same time, so the nodes are
+	// found in a hash table rather than by marking them.
+	std::vector<NodePtr> kept;
+	std::vector< std::vector<int> > children;
+	std::unordered_map<NodePtr, int> position;
+	position.reserve (2 * leaves.size());
+	int root = 0;
+	for (int i = 0; i < leaves.size(); i++)
+	{
+		NodePtr q = leaves[i];
+		int k = kept.size();
+		kept.push_back (q);
+		children.push_back (std::vector<int>());
+		position[q] = k;
+		while (q->GetAnc())
+		{
+			NodePtr a = q->GetAnc();
+			std::unordered_map<NodePtr, int>::iterator it = position.find (a);
+			if (it != position.end())
+			{
+				children[it->second].push_back (k);
+				break;
+			}
+			int ka = kept.size();
+			kept.push_back (a);
+			children.push_back (std::vector<int>(1, k));
+			position[a] = ka;
+			q = a;
+			k = ka;
+		}
+		if (q->GetAnc() == NULL)
+			root = k;
+	}
+
+	Root = copyInducedTraverse (kept, children, root);
+	Root->SetAnc (NULL);
+	CurNode = NULL;
+}
+
+//------------------------------------------------------------------------------
+// Copy the subtree rooted at kept[k], skipping any node with only one child,
+// and set the degrees and weights of the copies as Update would
+NodePtr Tree::copyInducedTraverse (const std::vector<NodePtr> &kept,
+	const std::vector< std::vector<int> > &children, int k)
+{
+	while ((children[k].size() == 1) && (kept[k]->GetDegree() != 1))
+		k = children[k][0];
+
+	NodePtr p = NewNode ();
+	kept[k]->Copy (p);
+	p->SetDegree (0);
+	p->SetWeight (0);
+	if (p->IsLeaf())
+	{
+		p->SetWeight (1);
+		Leaves++;
+	}
+	else
+		Internals++;
+
+	NodePtr last = NULL;
+	for (int i = 0; i < children[k].size(); i++)
+	{
+		NodePtr q = copyInducedTraverse (kept, children, children[k][i]);
+		q->SetAnc (p);
+		p->IncrementDegree ();
+		p->AddWeight (q->GetWeight());
+		if (last == NULL)
+			p->SetChild (q);
+		else
+			last->SetSibling (q);
+		last = q;
+	}
+	return p;
+}
+
 //------------------------------------------------------------------------------
 string Tree::GetErrorMsg ()
 {
@@ -1031,7 +1127,13 @@ void Tree::MakeNodeList ()
 {
 	if (Nodes == NULL)
 	{
-		Nodes = new NodePtr [Leaves + Internals];
+		// Trees built a node at a time (such as STree) don't keep an exact count
+		// of their internal nodes, so count the nodes to get the size of the list
+		NodeIterator <Node> n (Root);
+		int num_nodes = 0;
+		for (Node *q = n.begin(); q; q = n.next())
+			num_nodes++;
+		Nodes = new NodePtr [max (num_nodes, Leaves + Internals)];
 	}
 	count = Leaves;
 	makeNodeList (Root);
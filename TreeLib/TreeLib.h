@@ -42,6 +42,8 @@
 #include <stack>
 #include <map>
 
+#include "nodepool.h"
+
 
 #ifdef __BORLANDC__
     #pragma warn .pch
@@ -96,6 +98,10 @@ friend class Tree;
 public:
 	Node ();
 	virtual ~Node () {}; 
+
+	// Nodes of all classes are allocated from NodePool
+	static void *operator new (size_t size) { return NodePool::Allocate (size); };
+	static void operator delete (void *p, size_t size) { NodePool::Free (p, size); };
 	
 	virtual void 	AddWeight (int w) { Weight += w; };
 	virtual void	AppendLabel (const char *s) { Label += s; };
@@ -176,6 +182,7 @@ typedef Node *NodePtr;
 
 class Tree
 {
+friend class FlatTree;
 public:
 	Tree ();
 	Tree (const Tree &t);
@@ -184,6 +191,17 @@ public:
 	virtual void 	AddNodeBelow (NodePtr Node, NodePtr Below);
 
 	virtual NodePtr 	CopyOfSubtree (NodePtr RootedAt);
+	/**
+	 * Make this (empty) tree the subtree of t induced by a set of its leaves, i.e.
+	 * the tree that removing every other leaf with RemoveNode would leave. Nodes
+	 * left with only one child are suppressed, unless they had only one child in t.
+	 * This takes time proportional to the number of nodes on the paths from the
+	 * leaves to the root of t, rather than to the size of t. The degrees and
+	 * weights of the nodes are set, so there is no need to call Update.
+	 * @param t the tree, whose node degrees must be up to date (see Update)
+	 * @param leaves the leaves of t to keep, in left to right order
+	 */
+	virtual void	MakeInducedSubtree (const Tree &t, const std::vector<NodePtr> &leaves);
 
 #if defined __BORLANDC__ && (__BORLANDC__ < 0x0550)
 	virtual void 	Draw (ostream &f);
@@ -277,6 +295,8 @@ protected:
 
 	virtual void 		buildtraverse (NodePtr p);
    	virtual void 		copyTraverse (NodePtr p1, NodePtr &p2) const;
+	virtual NodePtr		copyInducedTraverse (const std::vector<NodePtr> &kept,
+							const std::vector< std::vector<int> > &children, int k);
    	virtual void 		deletetraverse (NodePtr p);
 	virtual void 		drawAsTextTraverse (NodePtr p);
 	virtual void 		drawLine (NodePtr p, bool isChild = false);
@@ -0,0 +1,193 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "clusterset.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+void ClusterSet::clear ()
+{
+	sparse = true;
+	num = 0;
+	words.clear();
+	elements.clear();
+}
+
+//------------------------------------------------------------------------------
+int ClusterSet::count (int i) const
+{
+	if (sparse)
+		return std::binary_search (elements.begin(), elements.end(), i) ? 1 : 0;
+	size_t w = (size_t)i / 64;
+	if (w >= words.size())
+		return 0;
+	return (int)((words[w] >> (i % 64)) & 1);
+}
+
+//------------------------------------------------------------------------------
+void ClusterSet::insert (int i)
+{
+	if (sparse)
+	{
+		std::vector<int>::iterator it = std::lower_bound (elements.begin(), elements.end(), i);
+		if ((it == elements.end()) || (*it != i))
+		{
+			elements.insert (it, i);
+			num++;
+		}
+	}
+	else
+	{
+		size_t w = (size_t)i / 64;
+		if (w >= words.size())
+			words.resize (w + 1, 0);
+		unsigned long long bit = 1ULL << (i % 64);
+		if ((words[w] & bit) == 0)
+		{
+			words[w] |= bit;
+			num++;
+		}
+	}
+	Normalise ();
+}
+
+//------------------------------------------------------------------------------
+ClusterSet &ClusterSet::operator|= (const ClusterSet &s)
+{
+	if (s.empty())
+		return *this;
+
+	if (sparse && s.sparse)
+	{
+		std::vector<int> merged;
+		merged.reserve (elements.size() + s.elements.size());
+		std::set_union (elements.begin(), elements.end(),
+			s.elements.begin(), s.elements.end(),
+			std::back_inserter (merged));
+		elements.swap (merged);
+		num = (int)elements.size();
+	}
+	else
+	{
+		if (sparse)
+			MakeDense ();
+		if (s.sparse)
+		{
+			for (size_t k = 0; k < s.elements.size(); k++)
+			{
+				int i = s.elements[k];
+				size_t w = (size_t)i / 64;
+				if (w >= words.size())
+					words.resize (w + 1, 0);
+				words[w] |= 1ULL << (i % 64);
+			}
+		}
+		else
+		{
+			if (s.words.size() > words.size())
+				words.resize (s.words.size(), 0);
+			for (size_t w = 0; w < s.words.size(); w++)
+				words[w] |= s.words[w];
+		}
+		num = 0;
+		for (size_t w = 0; w < words.size(); w++)
+			num += PopCount (words[w]);
+	}
+	Normalise ();
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+int ClusterSet::IntersectionSize (const ClusterSet &s) const
+{
+	int result = 0;
+	if (!sparse && !s.sparse)
+	{
+		size_t n = std::min (words.size(), s.words.size());
+		for (size_t w = 0; w < n; w++)
+			result += PopCount (words[w] & s.words[w]);
+	}
+	else if (sparse && s.sparse)
+	{
+		std::vector<int>::const_iterator i = elements.begin();
+		std::vector<int>::const_iterator j = s.elements.begin();
+		while ((i != elements.end()) && (j != s.elements.end()))
+		{
+			if (*i < *j)
+				i++;
+			else if (*j < *i)
+				j++;
+			else
+			{
+				result++;
+				i++;
+				j++;
+			}
+		}
+	}
+	else
+	{
+		// Look up each element of the sparse set in the dense one
+		const ClusterSet &a = sparse ? *this : s;
+		const ClusterSet &b = sparse ? s : *this;
+		for (size_t k = 0; k < a.elements.size(); k++)
+			result += b.count (a.elements[k]);
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------
+void ClusterSet::MakeDense ()
+{
+	words.assign (elements.empty() ? 0 : (size_t)elements.back() / 64 + 1, 0);
+	for (size_t k = 0; k < elements.size(); k++)
+		words[elements[k] / 64] |= 1ULL << (elements[k] % 64);
+	elements.clear();
+	sparse = false;
+}
+
+//------------------------------------------------------------------------------
+void ClusterSet::MakeSparse ()
+{
+	elements.clear();
+	elements.reserve (num);
+	for (const_iterator it = begin(); it != end(); ++it)
+		elements.push_back (*it);
+	words.clear();
+	sparse = true;
+}
+
+//------------------------------------------------------------------------------
+// Use a bitset unless it would have fewer than one element per word
+void ClusterSet::Normalise ()
+{
+	size_t limit = std::max ((size_t)num, (size_t)CLUSTERSET_MIN_WORDS);
+	if (sparse)
+	{
+		if (!elements.empty() && ((size_t)elements.back() / 64 + 1 <= limit))
+			MakeDense ();
+	}
+	else if (words.size() > limit)
+		MakeSparse ();
+}
@@ -0,0 +1,215 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file clusterset.h
+ *
+ * A set of small non-negative integers, held as a bitset
+ *
+ */
+
+#ifndef CLUSTERSETH
+#define CLUSTERSETH
+
+#include <iterator>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @def CLUSTERSET_MIN_WORDS
+ * A set whose elements all fit in this many 64-bit words is always stored
+ * as a bitset.
+ */
+#define CLUSTERSET_MIN_WORDS 4
+
+/**
+ * @class ClusterSet
+ * A set of non-negative integers, such as the leaf or label numbers in a
+ * cluster. The set is normally held as a bitset, so that the union of two
+ * clusters is an OR of words, and the size of an intersection is a popcount.
+ * If the largest element is so big that the bitset would have fewer
+ * than one element per 64-bit word (e.g., a small cluster in a tree drawn
+ * from a very large set of taxa) the set is held as a sorted vector
+ * instead. Which representation is used is hidden from the user of the class.
+ * Iterating over a ClusterSet visits the elements in increasing order,
+ * as for std::set.
+ *
+ */
+class ClusterSet
+{
+public:
+	ClusterSet () { sparse = true; num = 0; };
+
+	/**
+	 * @class const_iterator
+	 * Forward iterator over the elements, in increasing order.
+	 */
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef int							value_type;
+		typedef std::ptrdiff_t				difference_type;
+		typedef const int *					pointer;
+		typedef const int &					reference;
+
+		const_iterator () { s = NULL; pos = 0; bits = 0; };
+		const_iterator (const ClusterSet *set, size_t p) : s(set), pos(p), bits(0)
+		{
+			if (!s->sparse)
+				Skip ();
+		};
+
+		int operator* () const
+		{
+			return s->sparse ? s->elements[pos] : (int)(pos * 64) + LowestBit (bits);
+		};
+		const_iterator &operator++ ()
+		{
+			if (s->sparse)
+				pos++;
+			else
+			{
+				bits &= bits - 1;
+				if (bits == 0)
+				{
+					pos++;
+					Skip ();
+				}
+			}
+			return *this;
+		};
+		const_iterator operator++ (int) { const_iterator tmp = *this; ++(*this); return tmp; };
+		bool operator== (const const_iterator &it) const { return (pos == it.pos) && (bits == it.bits); };
+		bool operator!= (const const_iterator &it) const { return !(*this == it); };
+
+	protected:
+		// Move to the first non-empty word at or after pos
+		void Skip ()
+		{
+			while ((pos < s->words.size()) && (s->words[pos] == 0))
+				pos++;
+			bits = (pos < s->words.size()) ? s->words[pos] : 0;
+		};
+
+		const ClusterSet	*s;
+		size_t				pos;
+		unsigned long long	bits;
+	};
+	typedef const_iterator iterator;
+
+	/**
+	 * @return an iterator pointing to the smallest element
+	 */
+	const_iterator begin () const { return const_iterator (this, 0); };
+	/**
+	 * @return an iterator pointing past the largest element
+	 */
+	const_iterator end () const { return const_iterator (this, sparse ? elements.size() : words.size()); };
+
+	/**
+	 * Remove all elements.
+	 */
+	void clear ();
+	/**
+	 * @return true if the set is empty
+	 */
+	bool empty () const { return (num == 0); };
+	/**
+	 * @return the number of elements in the set
+	 */
+	int size () const { return num; };
+	/**
+	 * @param i an integer
+	 * @return 1 if i is in the set, otherwise 0
+	 */
+	int count (int i) const;
+	/**
+	 * Add i to the set.
+	 * @param i a non-negative integer
+	 */
+	void insert (int i);
+	/**
+	 * Replace this set by its union with s.
+	 * @param s a set
+	 */
+	ClusterSet &operator|= (const ClusterSet &s);
+	/**
+	 * @param s a set
+	 * @return the number of elements in both this set and s
+	 */
+	int IntersectionSize (const ClusterSet &s) const;
+
+	/**
+	 * @param x a 64-bit word
+	 * @return the number of bits set in x
+	 */
+	static int PopCount (unsigned long long x)
+	{
+#ifdef __GNUC__
+		return __builtin_popcountll (x);
+#else
+		int c = 0;
+		while (x)
+		{
+			x &= x - 1;
+			c++;
+		}
+		return c;
+#endif
+	};
+	/**
+	 * @param x a non-zero 64-bit word
+	 * @return the position of the lowest bit set in x
+	 */
+	static int LowestBit (unsigned long long x)
+	{
+#ifdef __GNUC__
+		return __builtin_ctzll (x);
+#else
+		int c = 0;
+		while ((x & 1) == 0)
+		{
+			x >>= 1;
+			c++;
+		}
+		return c;
+#endif
+	};
+
+protected:
+	void MakeDense ();
+	void MakeSparse ();
+	void Normalise ();
+
+	// true if the set is held in elements, otherwise it is held in words
+	bool						sparse;
+	// number of elements
+	int							num;
+	// bit (i % 64) of words[i / 64] is set if i is in the set
+	std::vector<unsigned long long>	words;
+	// the elements in increasing order
+	std::vector<int>			elements;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "flattree.h"
+
+
+//------------------------------------------------------------------------------
+void FlatTree::Clear ()
+{
+	parent.clear();
+	child.clear();
+	sibling.clear();
+	size.clear();
+	leaf.clear();
+	label_number.clear();
+	leaf_number.clear();
+	label.clear();
+	length.clear();
+	num_leaves		= 0;
+	name			= "";
+	weight			= 1.0;
+	rooted			= false;
+	edge_lengths	= false;
+	internal_labels	= false;
+}
+
+//------------------------------------------------------------------------------
+void FlatTree::AddNode (int a, Node *p)
+{
+	parent.push_back (a);
+	leaf.push_back (p->IsLeaf() ? 1 : 0);
+	label_number.push_back (p->IsLeaf() ? p->GetLabelNumber() : 0);
+	leaf_number.push_back (p->GetLeafNumber());
+	label.push_back (p->GetLabel());
+	length.push_back (p->GetEdgeLength());
+	if (p->IsLeaf())
+		num_leaves++;
+}
+
+//------------------------------------------------------------------------------
+void FlatTree::LinkNodes ()
+{
+	int n = (int)parent.size();
+	child.assign (n, -1);
+	sibling.assign (n, -1);
+	size.assign (n, 1);
+	std::vector<int> last (n, -1);
+	for (int v = 1; v < n; v++)
+	{
+		int a = parent[v];
+		if (last[a] == -1)
+			child[a] = v;
+		else
+			sibling[last[a]] = v;
+		last[a] = v;
+	}
+	// Descendants follow their ancestors in preorder
+	for (int v = n - 1; v > 0; v--)
+		size[parent[v]] += size[v];
+}
+
+//------------------------------------------------------------------------------
+void FlatTree::Assign (const Tree &t)
+{
+	Clear ();
+	name			= t.GetName ();
+	weight			= t.GetWeight ();
+	rooted			= t.IsRooted ();
+	edge_lengths	= t.GetHasEdgeLengths ();
+	internal_labels	= t.GetHasInternalLabels ();
+
+	NodePtr q = t.GetRoot();
+	if (q == NULL)
+		return;
+	int n = t.GetNumNodes();
+	parent.reserve (n);
+	leaf.reserve (n);
+	label_number.reserve (n);
+	leaf_number.reserve (n);
+	label.reserve (n);
+	length.reserve (n);
+
+	// Walk the tree in preorder. a is the number of the ancestor of q.
+	int a = -1;
+	for (;;)
+	{
+		int v = (int)parent.size();
+		AddNode (a, q);
+		if (q->GetChild())
+		{
+			a = v;
+			q = q->GetChild();
+			continue;
+		}
+		// Go up until we find a node with a sibling, stopping at the root
+		while ((v != 0) && (q->GetSibling() == NULL))
+		{
+			v = parent[v];
+			q = q->GetAnc();
+		}
+		if (v == 0)
+			break;
+		a = parent[v];
+		q = q->GetSibling();
+	}
+	LinkNodes ();
+}
+
+//------------------------------------------------------------------------------
+void FlatTree::ToTree (Tree &t) const
+{
+	t.Name				= name;
+	t.Weight			= weight;
+	t.Rooted			= rooted;
+	t.EdgeLengths		= edge_lengths;
+	t.InternalLabels	= internal_labels;
+	t.Leaves			= num_leaves;
+	t.Internals			= GetNumNodes() - num_leaves;
+	t.CurNode			= NULL;
+	t.Root				= NULL;
+
+	int n = GetNumNodes();
+	std::vector<NodePtr> nodes (n);
+	for (int v = 0; v < n; v++)
+	{
+		NodePtr p = t.NewNode ();
+		p->SetLeaf (leaf[v] != 0);
+		p->SetLabel (label[v]);
+		p->SetLabelNumber (label_number[v]);
+		p->SetLeafNumber (leaf_number[v]);
+		p->SetEdgeLength (length[v]);
+		p->SetWeight (leaf[v] ? 1 : 0);
+		nodes[v] = p;
+	}
+	// Link the nodes, and sum the degrees and weights from the leaves up
+	for (int v = n - 1; v >= 0; v--)
+	{
+		NodePtr p = nodes[v];
+		if (child[v] != -1)
+			p->SetChild (nodes[child[v]]);
+		if (sibling[v] != -1)
+			p->SetSibling (nodes[sibling[v]]);
+		if (parent[v] != -1)
+		{
+			NodePtr anc = nodes[parent[v]];
+			p->SetAnc (anc);
+			anc->IncrementDegree ();
+			anc->AddWeight (p->GetWeight());
+		}
+	}
+	if (n > 0)
+		t.Root = nodes[0];
+}
+
+//------------------------------------------------------------------------------
+void FlatTree::GetClusterBitsets (size_t words, std::vector<unsigned long long> &bits) const
+{
+	// Number the internal nodes in preorder, then take the union of the
+	// clusters from the leaves up
+	int n = GetNumNodes();
+	std::vector<int> index (n, -1);
+	int internals = 0;
+	for (int v = 0; v < n; v++)
+	{
+		if (!leaf[v])
+			index[v] = internals++;
+	}
+	bits.assign (internals * words, 0);
+	for (int v = n - 1; v > 0; v--)
+	{
+		unsigned long long *a = &bits[0] + index[parent[v]] * words;
+		if (leaf[v])
+			a[label_number[v] / 64] |= 1ULL << (label_number[v] % 64);
+		else
+		{
+			const unsigned long long *b = &bits[0] + index[v] * words;
+			for (size_t k = 0; k < words; k++)
+				a[k] |= b[k];
+		}
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file flattree.h
+ *
+ * A tree stored as arrays indexed by preorder number
+ *
+ */
+
+#ifndef FLATTREEH
+#define FLATTREEH
+
+#include <string>
+#include <vector>
+
+#include "TreeLib.h"
+
+/**
+ * @class FlatTree
+ * A read-mostly copy of a Tree, with the nodes numbered 0,...,n-1 in preorder
+ * (the root is 0, and children are visited from left to right) and the links
+ * and fields of the nodes held in arrays indexed by that number. Access is
+ * inline and non-virtual, and traversals need no stack: the descendants of
+ * node v are the nodes v,...,v+GetSize(v)-1, so the cluster of v is read off
+ * a contiguous range of the arrays.
+ *
+ * A FlatTree is made from a Tree by Assign (or the constructor), and converted
+ * back by ToTree. The node fields kept are those that Node::Copy copies.
+ */
+class FlatTree
+{
+friend class ProfileCache;
+public:
+	FlatTree () { Clear (); };
+	/**
+	 * Make a flat copy of t.
+	 * @param t a tree
+	 */
+	FlatTree (const Tree &t) { Assign (t); };
+
+	/**
+	 * Make this a flat copy of t.
+	 * @param t a tree
+	 */
+	void Assign (const Tree &t);
+	/**
+	 * Make this the empty tree.
+	 */
+	void Clear ();
+	/**
+	 * Build t from this tree. Degrees and weights of the nodes are set,
+	 * so there is no need to call Tree::Update.
+	 * @param t an empty tree
+	 */
+	void ToTree (Tree &t) const;
+
+	/**
+	 * Get the clusters of all the internal nodes as bitsets, in which bit j
+	 * is set if the leaf with label number j descends from the node.
+	 * @param words the number of 64 bit words in each bitset, which must be
+	 * more than the largest label number divided by 64
+	 * @param bits set to the bitsets of the internal nodes in preorder, one
+	 * after the other
+	 */
+	void GetClusterBitsets (size_t words, std::vector<unsigned long long> &bits) const;
+
+	int GetNumNodes () const { return (int)parent.size(); };
+	int GetNumLeaves () const { return num_leaves; };
+	/**
+	 * @return the root (0), or -1 if the tree is empty
+	 */
+	int GetRoot () const { return parent.empty() ? -1 : 0; };
+	/**
+	 * @return the ancestor of v, or -1 if v is the root
+	 */
+	int GetAnc (int v) const { return parent[v]; };
+	/**
+	 * @return the leftmost child of v, or -1 if v has no children
+	 */
+	int GetChild (int v) const { return child[v]; };
+	/**
+	 * @return the sibling to the right of v, or -1 if there is none
+	 */
+	int GetSibling (int v) const { return sibling[v]; };
+	/**
+	 * @return the number of nodes in the subtree rooted at v (including v)
+	 */
+	int GetSize (int v) const { return size[v]; };
+	bool IsLeaf (int v) const { return (leaf[v] != 0); };
+	/**
+	 * @return the label number of v (0 if v is not a leaf)
+	 */
+	int GetLabelNumber (int v) const { return label_number[v]; };
+	int GetLeafNumber (int v) const { return leaf_number[v]; };
+	const std::string &GetLabel (int v) const { return label[v]; };
+	float GetEdgeLength (int v) const { return length[v]; };
+
+	std::string GetName () const { return name; };
+	double GetWeight () const { return weight; };
+
+protected:
+	std::vector<int>			parent;
+	std::vector<int>			child;
+	std::vector<int>			sibling;
+	std::vector<int>			size;
+	std::vector<char>			leaf;
+	std::vector<int>			label_number;
+	std::vector<int>			leaf_number;
+	std::vector<std::string>	label;
+	std::vector<float>			length;
+	int							num_leaves;
+
+	std::string					name;
+	double						weight;
+	bool						rooted;
+	bool						edge_lengths;
+	bool						internal_labels;
+
+	// Add node v with ancestor a, copying its fields from node u of t
+	void AddNode (int a, Node *p);
+	// Set the child, sibling and size arrays from the parent array
+	void LinkNodes ();
+};
+
+#endif
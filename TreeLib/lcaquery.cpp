@@ -53,3 +53,108 @@ NodePtr SimpleLCAQuery::LCA (NodePtr i, NodePtr j)
     return p;
 }
 
+
+void LCAQuery::LCA (const std::vector< std::pair<NodePtr, NodePtr> > &queries,
+	std::vector<NodePtr> &result)
+{
+	result.resize (queries.size());
+	for (size_t k = 0; k < queries.size(); k++)
+		result[k] = LCA (queries[k].first, queries[k].second);
+}
+
+void EulerLCAQuery::Initialise ()
+{
+	number.clear();
+	nodes.clear();
+	first.clear();
+	depth.clear();
+	table.clear();
+	log2.clear();
+
+	NodePtr root = t->GetRoot();
+	if (root == NULL)
+		return;
+
+	// Walk the tree, adding a node to the tour when we first reach it and
+	// each time we return to it from one of its children
+	std::vector<int> tour;
+	NodePtr q = root;
+	bool done = false;
+	while (!done)
+	{
+		int v = nodes.size();
+		number[q] = v;
+		nodes.push_back (q);
+		depth.push_back ((q == root) ? 0 : depth[number[q->GetAnc()]] + 1);
+		first.push_back (tour.size());
+		tour.push_back (v);
+
+		if (q->GetChild())
+			q = q->GetChild();
+		else
+		{
+			// Go back up until we find a sibling to visit
+			for (;;)
+			{
+				if (q == root)
+				{
+					done = true;
+					break;
+				}
+				tour.push_back (number[q->GetAnc()]);
+				if (q->GetSibling())
+				{
+					q = q->GetSibling();
+					break;
+				}
+				q = q->GetAnc();
+			}
+		}
+	}
+
+	int m = tour.size();
+	log2.assign (m + 1, 0);
+	for (int i = 2; i <= m; i++)
+		log2[i] = log2[i / 2] + 1;
+	table.push_back (tour);
+	for (int k = 1; (1 << k) <= m; k++)
+	{
+		const std::vector<int> &prev = table[k - 1];
+		int half = 1 << (k - 1);
+		std::vector<int> row (m - (1 << k) + 1);
+		for (int p = 0; p < row.size(); p++)
+		{
+			int x = prev[p];
+			int y = prev[p + half];
+			row[p] = (depth[x] <= depth[y]) ? x : y;
+		}
+		table.push_back (row);
+	}
+}
+
+int EulerLCAQuery::Query (int a, int b) const
+{
+	if (a > b)
+		std::swap (a, b);
+	int k = log2[b - a + 1];
+	int x = table[k][a];
+	int y = table[k][b - (1 << k) + 1];
+	return (depth[x] <= depth[y]) ? x : y;
+}
+
+NodePtr EulerLCAQuery::LCA (NodePtr i, NodePtr j)
+{
+	return nodes[Query (first[number[i]], first[number[j]])];
+}
+
+void EulerLCAQuery::LCA (const std::vector< std::pair<NodePtr, NodePtr> > &queries,
+	std::vector<NodePtr> &result)
+{
+	result.resize (queries.size());
+	for (size_t k = 0; k < queries.size(); k++)
+	{
+		int a = first[number[queries[k].first]];
+		int b = first[number[queries[k].second]];
+		result[k] = nodes[Query (a, b)];
+	}
+}
@@ -41,6 +41,8 @@
     #pragma warn -pch
 #endif
 
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "TreeLib.h"
@@ -58,6 +60,13 @@ public:
 	LCAQuery (Tree *tree);
     virtual ~LCAQuery () {};
     virtual NodePtr LCA (NodePtr i, NodePtr j) = 0;
+	/**
+	 * Answer a batch of queries.
+	 * @param queries pairs of nodes
+	 * @param result on return result[k] is the LCA of the nodes in queries[k]
+	 */
+	virtual void LCA (const std::vector< std::pair<NodePtr, NodePtr> > &queries,
+		std::vector<NodePtr> &result);
     virtual void SetTree (Tree *tree);
 protected:
 	Tree *t;
@@ -88,6 +97,43 @@ protected:
 	virtual void Initialise ();
 };
 
+/**
+ * @class EulerLCAQuery
+ * Constant time LCA queries. Initialise makes an Euler tour of the tree (the
+ * sequence of nodes visited by a depth first walk, listing a node each time
+ * the walk reaches it) and a sparse table of the shallowest node in each
+ * range of the tour whose length is a power of two, which takes O(n log n)
+ * time and space. The LCA of i and j is the shallowest node in the tour between
+ * the first visits to i and j, which is the shallower of the minima of two
+ * overlapping ranges in the table.
+ */
+class EulerLCAQuery : public LCAQuery
+{
+public:
+	EulerLCAQuery () {};
+	EulerLCAQuery (Tree *tree) :  LCAQuery (tree) { Initialise (); };
+	/**
+	 * @return LCA of nodes i and j
+	 */
+    virtual NodePtr LCA (NodePtr i, NodePtr j);
+	virtual void LCA (const std::vector< std::pair<NodePtr, NodePtr> > &queries,
+		std::vector<NodePtr> &result);
+protected:
+	// Number of each node in nodes
+	std::unordered_map<Node *, int> number;
+	std::vector<NodePtr> nodes;
+	// Position of the first visit to each node in the tour
+	std::vector<int> first;
+	// table[k][p] is the node of least depth in tour[p],...,tour[p + 2^k - 1]
+	std::vector< std::vector<int> > table;
+	std::vector<int> depth;
+	// floor of log2 of 1,...,length of tour
+	std::vector<int> log2;
+
+	virtual void Initialise ();
+	int Query (int a, int b) const;
+};
+
 #if __BORLANDC__
 	// Redefine __MINMAX_DEFINED so Windows header files compile
 	#ifndef __MINMAX_DEFINED
@@ -0,0 +1,120 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "mappedfile.h"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#define USE_MMAP 1
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------
+MappedFile::MappedFile ()
+{
+	data = NULL;
+	size = 0;
+	is_open = false;
+	mapped = false;
+}
+
+//------------------------------------------------------------------------------
+MappedFile::~MappedFile ()
+{
+	Close ();
+}
+
+//------------------------------------------------------------------------------
+bool MappedFile::Open (const char *filename)
+{
+	Close ();
+
+#ifdef USE_MMAP
+	int fd = open (filename, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if ((fstat (fd, &st) == 0) && S_ISREG (st.st_mode))
+	{
+		size = (size_t)st.st_size;
+		if (size == 0)
+		{
+			// mmap does not accept an empty file
+			data = "";
+			is_open = true;
+		}
+		else
+		{
+			void *p = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+#ifdef MADV_SEQUENTIAL
+				madvise (p, size, MADV_SEQUENTIAL);
+#endif
+				data = (const char *)p;
+				mapped = true;
+				is_open = true;
+			}
+		}
+	}
+	close (fd);
+	if (is_open)
+		return true;
+	size = 0;
+#endif
+
+	// Read the whole file
+	std::ifstream f (filename, std::ios::in | std::ios::binary);
+	if (!f)
+		return false;
+	char block[65536];
+	while (f.read (block, sizeof (block)) || (f.gcount() > 0))
+		buffer.insert (buffer.end(), block, block + f.gcount());
+	if (f.bad())
+	{
+		buffer.clear ();
+		return false;
+	}
+	data = buffer.empty() ? "" : &buffer[0];
+	size = buffer.size();
+	is_open = true;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void MappedFile::Close ()
+{
+#ifdef USE_MMAP
+	if (mapped)
+		munmap ((void *)data, size);
+#endif
+	std::vector<char>().swap (buffer);
+	data = NULL;
+	size = 0;
+	is_open = false;
+	mapped = false;
+}
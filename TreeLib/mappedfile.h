@@ -0,0 +1,88 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file mappedfile.h
+ *
+ * Read-only access to the whole of a file in memory
+ *
+ */
+
+#ifndef MAPPEDFILEH
+#define MAPPEDFILEH
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class MappedFile
+ * The contents of a file, as one block of memory. On POSIX systems the file
+ * is mapped with mmap, so no copy is made, and reading it costs page faults
+ * rather than a system call per buffer. Elsewhere, or if the file cannot be
+ * mapped (e.g., it is a pipe), the file is read into a buffer in one go. The
+ * data is not terminated by a null character.
+ *
+ */
+class MappedFile
+{
+public:
+	MappedFile ();
+	virtual ~MappedFile ();
+
+	/**
+	 * Map a file, closing any file already open.
+	 * @param filename name of the file
+	 * @return true if successful
+	 */
+	virtual bool Open (const char *filename);
+	/**
+	 * Unmap the file. Pointers returned by GetData are no longer valid.
+	 */
+	virtual void Close ();
+	/**
+	 * @return true if a file is open
+	 */
+	bool IsOpen () const { return is_open; };
+	/**
+	 * @return the first byte of the file
+	 */
+	const char *GetData () const { return data; };
+	/**
+	 * @return the number of bytes in the file
+	 */
+	size_t GetSize () const { return size; };
+
+protected:
+	const char			*data;
+	size_t				size;
+	bool				is_open;
+	// true if data is mapped, otherwise it points into buffer
+	bool				mapped;
+	std::vector<char>	buffer;
+
+private:
+	MappedFile (const MappedFile &);
+	MappedFile &operator= (const MappedFile &);
+};
+
+#endif
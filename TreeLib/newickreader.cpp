@@ -0,0 +1,666 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "newickreader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stack>
+#include <vector>
+
+#define NW_SPACE	1
+#define NW_PUNCT	2
+
+/**
+ * @struct CharClasses
+ * The characters that Tokeniser treats as white space and as punctuation.
+ * Carriage returns are white space as Tokeniser turns them into newlines,
+ * and so is the null character, which Tokeniser skips.
+ */
+struct CharClasses
+{
+	unsigned char c[256];
+
+	CharClasses ()
+	{
+		memset (c, 0, sizeof (c));
+		const char *space = " \t\n\r";
+		for (const char *p = space; *p; p++)
+			c[(unsigned char)*p] = NW_SPACE;
+		c[0] = NW_SPACE;
+		const char *punctuation = "()[]{}/\\,;:=*'\"`+-<>!#";
+		for (const char *p = punctuation; *p; p++)
+			c[(unsigned char)*p] = NW_PUNCT;
+	};
+};
+
+static const CharClasses char_class;
+
+// The token at the end of the text, which for Tokeniser is the null character
+static const char null_token = '\0';
+
+//------------------------------------------------------------------------------
+static inline bool IsSpace (char ch)
+{
+	return (char_class.c[(unsigned char)ch] & NW_SPACE) != 0;
+}
+
+//------------------------------------------------------------------------------
+static inline bool IsPunctuation (char ch)
+{
+	return (char_class.c[(unsigned char)ch] & NW_PUNCT) != 0;
+}
+
+//------------------------------------------------------------------------------
+// The text from p to e as Tokeniser would return it: a line break is a single
+// newline and, in a token, an underscore is a space, and in a quoted string a
+// pair of quotes is one quote
+static std::string MakeString (const char *p, const char *e, bool token, bool quoted)
+{
+	std::string s;
+	s.reserve (e - p);
+	while (p < e)
+	{
+		char ch = *p++;
+		if (ch == '\r')
+		{
+			if ((p < e) && (*p == '\n'))
+				p++;
+			ch = '\n';
+		}
+		else if ((ch == '_') && token)
+			ch = ' ';
+		else if (quoted && (ch == '\''))
+			p++;
+		s += ch;
+	}
+	return s;
+}
+
+//------------------------------------------------------------------------------
+NewickScanner::NewickScanner (const char *t, size_t length)
+{
+	text = t;
+	end = t + length;
+	pos = t;
+	token_start = &null_token;
+	token_length = 1;
+	quoted = false;
+}
+
+//------------------------------------------------------------------------------
+Tokeniser::tokentype NewickScanner::GetNextToken ()
+{
+	quoted = false;
+	for (;;)
+	{
+		while ((pos < end) && IsSpace (*pos))
+			pos++;
+		if (pos == end)
+		{
+			token_start = &null_token;
+			token_length = 1;
+			return Tokeniser::EMPTY;
+		}
+
+		char ch = *pos;
+		if (ch == '[')
+		{
+			ParseComment ();
+			continue;
+		}
+
+		token_start = pos;
+		if (ch == '\'')
+		{
+			if (ParseString ())
+				return Tokeniser::STRING;
+			token_start = &null_token;
+			token_length = 1;
+			return Tokeniser::BAD;
+		}
+		if (IsPunctuation (ch))
+		{
+			pos++;
+			token_length = 1;
+			switch (ch)
+			{
+				case '(':
+				case '{':
+					return Tokeniser::LPAR;
+				case ')':
+				case '}':
+					return Tokeniser::RPAR;
+				case '!':
+					return Tokeniser::BANG;
+				case '#':
+					return Tokeniser::HASH;
+				case '=':
+					return Tokeniser::EQUALS;
+				case ';':
+					return Tokeniser::SEMICOLON;
+				case ',':
+					return Tokeniser::COMMA;
+				case '*':
+					return Tokeniser::ASTERIX;
+				case ':':
+					return Tokeniser::COLON;
+				case '-':
+					return Tokeniser::MINUS;
+				case '"':
+					return Tokeniser::DOUBLEQUOTE;
+				case '/':
+					return Tokeniser::BACKSLASH;
+				default:
+					return Tokeniser::OTHER;
+			}
+		}
+		if (isdigit ((unsigned char)ch))
+			return ParseNumber ();
+
+		// A label runs to the next white space or punctuation
+		while ((pos < end) && !IsSpace (*pos) && !IsPunctuation (*pos))
+			pos++;
+		token_length = pos - token_start;
+		return Tokeniser::STRING;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Parse a number (integer or real), using the same state machine as
+// Tokeniser::ParseNumber so that the same text is accepted.
+Tokeniser::tokentype NewickScanner::ParseNumber ()
+{
+	enum {
+		start		= 0x0001,
+		sign		= 0x0002,
+		digit		= 0x0004,
+		fraction	= 0x0008,
+		expsymbol	= 0x0010,
+		expsign		= 0x0020,
+		exponent 	= 0x0040,
+		bad			= 0x0080,
+		done		= 0x0100
+	};
+
+	int state = start;
+	quoted = false;
+	const char *p = token_start;
+	while (p < end)
+	{
+		char ch = *p;
+		if (IsSpace (ch) || (IsPunctuation (ch) && (ch != '-')))
+			break;
+		if (isdigit ((unsigned char)ch))
+		{
+			if ((state == start) || (state == sign))
+				state = digit;
+			else if ((state == expsymbol) || (state == expsign))
+				state = exponent;
+		}
+		else if (ch == '-')
+		{
+			if (state == start)
+				state = sign;
+			else if (state == digit)
+				state = done;		// minus sign is punctuation, such as 6-10
+			else if (state == expsymbol)
+				state = expsign;
+			else
+				state = bad;
+		}
+		else if ((ch == '.') && (state == digit))
+			state = fraction;
+		else if (((ch == 'E') || (ch == 'e')) && (state & (digit | fraction)))
+			state = expsymbol;
+		else
+			state = bad;
+
+		if ((state == bad) || (state == done))
+			break;
+		p++;
+	}
+
+	Tokeniser::tokentype result = Tokeniser::NUMBER;
+	if ((state & (digit | fraction | exponent | done)) == 0)
+	{
+		// Not a number, but a string that starts with numbers, such as "00BW0762.1"
+		if (p < end)
+		{
+			do {
+				p++;
+			} while ((p < end) && (isalnum ((unsigned char)*p) || (*p == '_') || (*p == '.')));
+		}
+		result = Tokeniser::STRING;
+	}
+	token_length = p - token_start;
+
+	// Tokeniser puts back punctuation that follows the token, but not
+	// anything else
+	pos = ((p < end) && !IsPunctuation (*p)) ? p + 1 : p;
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Find the end of a quoted string, which starts at pos. A pair of quotes
+// inside the string stands for one quote.
+bool NewickScanner::ParseString ()
+{
+	const char *p = pos + 1;
+	for (;;)
+	{
+		const char *q = (const char *)memchr (p, '\'', end - p);
+		if (q == NULL)
+		{
+			pos = end;
+			return false;
+		}
+		if ((q + 1 < end) && (q[1] == '\''))
+			p = q + 2;
+		else
+		{
+			token_start = pos + 1;
+			token_length = q - token_start;
+			quoted = true;
+			pos = q + 1;
+			return true;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Skip a NEXUS-style comment, which starts at pos, echoing it if it
+// starts with "!"
+void NewickScanner::ParseComment ()
+{
+	pos++;
+	bool echo = (pos < end) && (*pos == '!');
+	if (echo)
+		pos++;
+	const char *close = (const char *)memchr (pos, ']', end - pos);
+	if (close == NULL)
+		close = end;
+	if (echo)
+		std::cout << MakeString (pos, close, false, false);
+	pos = (close < end) ? close + 1 : end;
+}
+
+//------------------------------------------------------------------------------
+std::string NewickScanner::GetToken () const
+{
+	return MakeString (token_start, token_start + token_length, true, quoted);
+}
+
+//------------------------------------------------------------------------------
+long NewickScanner::GetFileLine () const
+{
+	long line = 1;
+	for (const char *p = text; p < pos; p++)
+	{
+		if ((*p == '\n') || ((*p == '\r') && ((p + 1 == end) || (p[1] != '\n'))))
+			line++;
+	}
+	return line;
+}
+
+//------------------------------------------------------------------------------
+long NewickScanner::GetFileColumn () const
+{
+	const char *p = pos;
+	while ((p > text) && (p[-1] != '\n') && (p[-1] != '\r'))
+		p--;
+	return (long)(pos - p) + 1;
+}
+
+//------------------------------------------------------------------------------
+bool FindTreeEnds (const char *text, size_t length, std::vector<size_t> &ends)
+{
+	ends.clear ();
+	const char *p = text;
+	const char *end = text + length;
+	while (p < end)
+	{
+		const char *q;
+		switch (*p++)
+		{
+			case ';':
+				ends.push_back (p - text);
+				break;
+			case '\'':
+				// A pair of quotes inside a quoted string is one quote
+				for (;;)
+				{
+					q = (const char *)memchr (p, '\'', end - p);
+					if (q == NULL)
+						p = end;
+					else if ((q + 1 < end) && (q[1] == '\''))
+					{
+						p = q + 2;
+						continue;
+					}
+					else
+						p = q + 1;
+					break;
+				}
+				break;
+			case '[':
+				if ((p < end) && (*p == '!'))
+					return false;
+				q = (const char *)memchr (p, ']', end - p);
+				p = (q == NULL) ? end : q + 1;
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+bool NewickReader::LabelEdge ()
+{
+	bool result = false;
+	Tokeniser::tokentype token = scanner.GetNextToken ();
+
+	// Handle negative branch lengths by calling ParseNumber from the "-"
+	if (token == Tokeniser::MINUS)
+		result = (scanner.ParseNumber () != Tokeniser::BAD);
+	else
+		result = (token == Tokeniser::NUMBER);
+
+	if (result)
+	{
+		// Convert token to a number
+		char number_string[128], *endptr;
+		size_t length = std::min (scanner.GetTokenLength (), sizeof (number_string) - 1);
+		memcpy (number_string, scanner.GetTokenStart (), length);
+		number_string[length] = '\0';
+		double value = strtod (number_string, &endptr);
+		if (*endptr == '\0')
+		{
+			// Set -ve branch lengths to zero
+			if (value < 0.0)
+				value = 0.0;
+			tree->GetCurNode()->SetEdgeLength (value);
+			tree->SetEdgeLengths (true);
+		}
+		else
+		{
+			errormsg = "The token ";
+			errormsg += scanner.GetToken();
+			errormsg += " is not a valid number";
+		}
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------
+bool NewickReader::LabelLeaf (const std::string &s)
+{
+	tree->MakeCurNodeALeaf (tree->GetNumLeaves() + 1);
+	tree->GetCurNode()->SetLabel (s);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void NewickReader::LabelInternalNode (const std::string &s)
+{
+	tree->GetCurNode()->SetLabel (s);
+	tree->SetInternalLabels (true);
+}
+
+//------------------------------------------------------------------------------
+// The same pushdown automaton as TreeReader::Read
+bool NewickReader::Read (TreePtr t)
+{
+	// States of pushdown automaton that reads trees
+	enum statetype
+	{
+		GETNAME,
+		GETINTERNODE,
+		NEXTMOVE,
+		DOSIBLING,
+		FINISHCHILDREN,
+		ACCEPTED,
+		CLEANUP,
+		QUIT
+	} state;
+
+	std::stack< NodePtr, std::vector<NodePtr> > stk;
+	Tokeniser::tokentype 	token;
+
+	tree = t;
+	tree->MakeRoot();
+	token = scanner.GetNextToken ();
+
+	if (token == Tokeniser::EMPTY)
+		return false;
+
+	// Parse the tree description
+	state = GETNAME;
+	while ((state != QUIT) && (state != ACCEPTED))
+	{
+		switch (state)
+		{
+			case GETNAME:
+				switch (token)
+				{
+					case Tokeniser::STRING:
+					case Tokeniser::NUMBER:
+						LabelLeaf (scanner.GetToken());
+						token = scanner.GetNextToken ();
+						state = GETINTERNODE;
+						break;
+					case Tokeniser::LPAR:
+						state = NEXTMOVE;
+						break;
+					default:
+						errormsg = "Syntax error [GETNAME]: expecting a \"(\" or leaf name, got \"";
+						errormsg += scanner.GetToken();
+						errormsg += "\" instead";
+						state = QUIT;
+						break;
+				}
+				break;
+
+			case GETINTERNODE:
+				switch (token)
+				{
+					case Tokeniser::COLON:
+					case Tokeniser::COMMA:
+					case Tokeniser::RPAR:
+						state = NEXTMOVE;
+						break;
+					default:
+						errormsg = "Syntax error [GETINTERNODE]: expecting one of \":,)\", got ";
+						errormsg += scanner.GetToken();
+						errormsg += " instead";
+						state = QUIT;
+						break;
+				}
+				break;
+
+			case NEXTMOVE:
+				switch (token)
+				{
+					case Tokeniser::COLON:
+						if (LabelEdge ())
+							token = scanner.GetNextToken ();
+						else
+							state = QUIT;
+						break;
+					// The next node encountered will be a sibling
+					// of Curnode and a descendant of the node on
+					// the top of the node stack.
+					case Tokeniser::COMMA:
+						if (stk.empty())
+						{
+							errormsg = "Tree description unbalanced, this \")\" has no matching \"(\"";
+							state = QUIT;
+						}
+						else
+						{
+							tree->MakeSibling ();
+							token = scanner.GetNextToken ();
+							state = GETNAME;
+						}
+						break;
+					// The next node will be a child of CurNode, hence
+					// we create the node and push CurNode onto the
+					// node stack.
+					case Tokeniser::LPAR:
+						stk.push (tree->GetCurNode());
+						tree->MakeChild();
+						token = scanner.GetNextToken ();
+						state = GETNAME;
+						break;
+					// We've finished ready the descendants of the node
+					// at the top of the node stack so pop it off.
+					case Tokeniser::RPAR:
+						if (stk.empty())
+						{
+							errormsg = "Tree description unbalanced (an extra \")\")";
+							state = QUIT;
+						}
+						else
+						{
+							NodePtr q = stk.top();
+							q->AddWeight(tree->GetCurNode()->GetWeight());
+							tree->SetCurNode (q);
+							stk.pop ();
+							token = scanner.GetNextToken ();
+							state = FINISHCHILDREN;
+						}
+						break;
+					// We should have finished the tree
+					case Tokeniser::SEMICOLON:
+						if (stk.empty())
+						{
+							state = ACCEPTED;
+						}
+						else
+						{
+							errormsg = "Tree description ended prematurely (stack not empty)";
+							state = QUIT;
+						}
+						break;
+					default:
+						errormsg = "Syntax error [NEXTMOVE]: expecting one of \":,();\", got ";
+						errormsg += scanner.GetToken();
+						errormsg += " instead";
+						state = QUIT;
+						break;
+				}
+				break;
+
+			case FINISHCHILDREN:
+				switch (token)
+				{
+					case Tokeniser::STRING:
+					case Tokeniser::NUMBER:
+						LabelInternalNode (scanner.GetToken());
+						token = scanner.GetNextToken ();
+						break;
+					case Tokeniser::COLON:
+						if (LabelEdge ())
+							token = scanner.GetNextToken ();
+						else
+							state = QUIT;
+						break;
+					// We've completed traversing the descendants of the
+					// node at the top of the stack, so pop it off.
+					case Tokeniser::RPAR:
+						if (stk.empty())
+						{
+							errormsg = "Tree description unbalanced, this \")\" has no matching \"(\"";
+							state = QUIT;
+						}
+						else
+						{
+							NodePtr q = stk.top();
+							q->AddWeight(tree->GetCurNode()->GetWeight());
+							tree->SetCurNode (q);
+							stk.pop ();
+							token = scanner.GetNextToken ();
+						}
+						break;
+
+					// The node at the top of the stack still has some
+					// descendants.
+					case Tokeniser::COMMA:
+						if (stk.empty())
+						{
+							errormsg = "Tree description unbalanced, missing a \"(\"";
+							state = QUIT;
+						}
+						else
+						{
+							tree->MakeSibling ();
+							token = scanner.GetNextToken ();
+							state = GETNAME;
+						}
+						break;
+					case Tokeniser::SEMICOLON:
+						state = NEXTMOVE;
+						break;
+					default:
+						if (stk.empty())
+						{
+							errormsg = "Tree description unbalanced";
+							state = QUIT;
+						}
+						else
+						{
+							errormsg = "Syntax error [FINISHCHILDREN]: expecting one of \":,();\" or internal label, got ";
+							errormsg += scanner.GetToken();
+							errormsg += " instead";
+						}
+						state = QUIT;
+						break;
+				}
+				break;
+		}
+	}
+	// Handle errors
+	if (state == QUIT)
+	{
+		 throw XTokeniser (errormsg, scanner.GetFilePosition(),
+			scanner.GetFileLine (), scanner.GetFileColumn());
+	}
+	else
+	{
+		tree->GetRoot()->SetWeight(tree->GetNumLeaves());
+		doAdjust ();
+	}
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Unrooted PHYLIP trees have degree > 2
+void NewickReader::doAdjust ()
+{
+	tree->SetRooted (tree->GetRoot()->GetDegree() == 2);
+}
@@ -0,0 +1,154 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file newickreader.h
+ *
+ * Read Newick (PHYLIP) trees from text held in memory
+ *
+ */
+
+#ifndef NEWICKREADERH
+#define NEWICKREADERH
+
+#include <string>
+#include <vector>
+
+#include "TreeLib.h"
+#include "tokeniser.h"
+
+/**
+ * @class NewickScanner
+ * Splits Newick text held in memory (such as a MappedFile) into the same
+ * tokens as Tokeniser, but in place. Tokeniser reads a character at a time
+ * from a stream, asking the stream for its position after each one, and
+ * copies each token into a string. Here a token is just a pointer into the
+ * text and a length, and a string is only made when the caller asks for the
+ * text of the token (see GetToken). The line and column of the current
+ * position are worked out only when they are asked for, e.g. for an error
+ * message.
+ *
+ */
+class NewickScanner
+{
+public:
+	/**
+	 * @param text the start of the text, which need not be null terminated
+	 * @param length number of characters
+	 */
+	NewickScanner (const char *text, size_t length);
+	virtual ~NewickScanner () {};
+
+	/**
+	 * Move to the next token, skipping white space and comments. As for
+	 * Tokeniser, a comment that starts with "!" is written to cout.
+	 * @return the type of the token, EMPTY at the end of the text
+	 */
+	Tokeniser::tokentype GetNextToken ();
+	/**
+	 * Read a number that starts at the start of the current token (such as
+	 * a "-" that GetNextToken has returned as MINUS), and make it the
+	 * current token.
+	 * @return NUMBER, or STRING if the text is not a number
+	 */
+	Tokeniser::tokentype ParseNumber ();
+	/**
+	 * @return the text of the current token. In a label, underscores become
+	 * spaces, and in a quoted label a pair of single quotes becomes one.
+	 */
+	std::string GetToken () const;
+	/**
+	 * @return the first character of the current token, as it is in the text
+	 */
+	const char *GetTokenStart () const { return token_start; };
+	/**
+	 * @return the length of the current token, as it is in the text
+	 */
+	size_t GetTokenLength () const { return token_length; };
+
+	long GetFileColumn () const;
+	long GetFileLine () const;
+	long GetFilePosition () const { return (long)(pos - text); };
+
+protected:
+	const char	*text;
+	const char	*end;
+	// next character to be read
+	const char	*pos;
+	const char	*token_start;
+	size_t		token_length;
+	// true if the token was a quoted string
+	bool		quoted;
+
+	bool ParseString ();
+	void ParseComment ();
+};
+
+/**
+ * @class NewickReader
+ * Reads a tree from a NewickScanner, using the same pushdown automaton, and
+ * building the same tree, as PHYLIPReader does from a Tokeniser.
+ *
+ */
+class NewickReader
+{
+public:
+	NewickReader (NewickScanner &s) : scanner (s) { tree = NULL; };
+	virtual ~NewickReader () {};
+
+	/**
+	 * Read the next tree.
+	 * @param t an empty tree
+	 * @return true if a tree was read, false if there are no more trees
+	 * @exception XTokeniser if the tree description has an error
+	 */
+	virtual bool Read (TreePtr t);
+
+protected:
+	NewickScanner	&scanner;
+	Tree			*tree;
+	std::string		errormsg;
+
+	virtual void 	doAdjust ();
+	virtual bool 	LabelEdge ();
+	virtual bool 	LabelLeaf (const std::string &s);
+	virtual void 	LabelInternalNode (const std::string &s);
+};
+
+/**
+ * @fn bool FindTreeEnds (const char *text, size_t length, std::vector<size_t> &ends)
+ * @brief find where each tree description in Newick text ends
+ *
+ * A tree ends at a ";" that is not in a quoted string or a comment. This is
+ * a quick pass over the text, much faster than tokenising it, so that the
+ * trees can then be read in parallel, each by its own NewickScanner.
+ *
+ * @param text the text
+ * @param length number of characters
+ * @param ends the offset of the character after each ";", in order
+ * @return false if the text has a comment to be echoed ("[!...]"), in which
+ * case the trees should be read in order
+ */
+bool FindTreeEnds (const char *text, size_t length, std::vector<size_t> &ends);
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "nodepool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#define NODEPOOL_CLASSES (NODEPOOL_MAX_SIZE / NODEPOOL_GRANULE)
+
+/**
+ * @struct FreeList
+ * Free blocks of one size, linked through their first word.
+ */
+struct FreeList
+{
+	void	*head;
+	int		chunk;		// number of blocks in the next chunk
+};
+
+static thread_local FreeList free_lists[NODEPOOL_CLASSES];
+
+static std::atomic<long> num_allocations (0);
+static std::atomic<long> num_system_allocations (0);
+
+//------------------------------------------------------------------------------
+// Link a new chunk of blocks of class c into its free list
+static void Refill (FreeList &list, int c)
+{
+	if (list.chunk == 0)
+		list.chunk = 32;
+	size_t block = (size_t)(c + 1) * NODEPOOL_GRANULE;
+	char *chunk = (char *)malloc (block * list.chunk);
+	if (chunk == NULL)
+		throw std::bad_alloc ();
+	num_system_allocations.fetch_add (1, std::memory_order_relaxed);
+	for (int i = list.chunk - 1; i >= 0; i--)
+	{
+		void **p = (void **)(chunk + i * block);
+		*p = list.head;
+		list.head = p;
+	}
+	if (list.chunk < NODEPOOL_MAX_CHUNK)
+		list.chunk *= 2;
+}
+
+//------------------------------------------------------------------------------
+void *NodePool::Allocate (size_t size)
+{
+	num_allocations.fetch_add (1, std::memory_order_relaxed);
+	if ((size == 0) || (size > NODEPOOL_MAX_SIZE))
+	{
+		num_system_allocations.fetch_add (1, std::memory_order_relaxed);
+		return ::operator new (size);
+	}
+	int c = (int)((size - 1) / NODEPOOL_GRANULE);
+	FreeList &list = free_lists[c];
+	if (list.head == NULL)
+		Refill (list, c);
+	void **p = (void **)list.head;
+	list.head = *p;
+	return p;
+}
+
+//------------------------------------------------------------------------------
+void NodePool::Free (void *p, size_t size)
+{
+	if (p == NULL)
+		return;
+	if ((size == 0) || (size > NODEPOOL_MAX_SIZE))
+	{
+		::operator delete (p);
+		return;
+	}
+	FreeList &list = free_lists[(size - 1) / NODEPOOL_GRANULE];
+	*(void **)p = list.head;
+	list.head = p;
+}
+
+//------------------------------------------------------------------------------
+long NodePool::GetNumAllocations ()
+{
+	return num_allocations;
+}
+
+//------------------------------------------------------------------------------
+long NodePool::GetNumSystemAllocations ()
+{
+	return num_system_allocations;
+}
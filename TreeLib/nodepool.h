@@ -0,0 +1,96 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file nodepool.h
+ *
+ * A pool allocator for tree nodes
+ *
+ */
+
+#ifndef NODEPOOLH
+#define NODEPOOLH
+
+#include <cstddef>
+
+/**
+ * @def NODEPOOL_GRANULE
+ * Requests are rounded up to a multiple of this many bytes, and each
+ * multiple has its own free list.
+ */
+#define NODEPOOL_GRANULE 16
+
+/**
+ * @def NODEPOOL_MAX_SIZE
+ * Larger requests are passed to the global operator new.
+ */
+#define NODEPOOL_MAX_SIZE 512
+
+/**
+ * @def NODEPOOL_MAX_CHUNK
+ * The largest number of blocks taken from the system in one allocation.
+ */
+#define NODEPOOL_MAX_CHUNK 4096
+
+/**
+ * @class NodePool
+ * Allocates the nodes of trees. Freed nodes are kept on a free list for
+ * their size, and new nodes are taken from that list, so building a tree
+ * after another has been deleted (e.g., copying a tree in each step of a
+ * loop) does not touch the system allocator at all. When a free list is
+ * empty it is refilled with one allocation of a chunk of blocks, each chunk
+ * twice the size of the last (up to NODEPOOL_MAX_CHUNK blocks), so building
+ * a tree with n nodes from scratch costs O(log n) system allocations.
+ *
+ * Each thread has its own free lists, so no locking is needed. A node may
+ * be freed by a different thread to the one that allocated it, in which
+ * case the block joins the free list of the thread that frees it. Chunks
+ * are never returned to the system.
+ *
+ */
+class NodePool
+{
+public:
+	/**
+	 * @param size number of bytes
+	 * @return a block of at least size bytes
+	 */
+	static void *Allocate (size_t size);
+	/**
+	 * Return a block to the pool.
+	 * @param p a block returned by Allocate
+	 * @param size the size that was passed to Allocate
+	 */
+	static void Free (void *p, size_t size);
+
+	/**
+	 * @return the number of blocks allocated so far
+	 */
+	static long GetNumAllocations ();
+	/**
+	 * @return the number of calls made to the system allocator so far
+	 */
+	static long GetNumSystemAllocations ();
+};
+
+#endif
@@ -10,7 +10,7 @@ void NTree::BuildClustersTraverse (NNodePtr p)
 {
 	if (p)
     {
-    	p->Cluster.erase (p->Cluster.begin(), p->Cluster.end());
+    	p->Cluster.clear ();
         BuildClustersTraverse ((NNodePtr)(p->GetChild()));
         BuildClustersTraverse ((NNodePtr)(p->GetSibling()));
         if (p->IsLeaf())
@@ -29,11 +29,7 @@ void NTree::BuildClustersTraverse (NNodePtr p)
         if (p !=Root)
         {
         	NNodePtr anc = (NNodePtr)(p->GetAnc());
-			std::set<int, less<int> > temp_set;
-			std::set_union(anc->Cluster.begin(), anc->Cluster.end(),
-				p->Cluster.begin(), p->Cluster.end(),
-				std::inserter(temp_set, temp_set.begin()));
-			anc->Cluster.swap(temp_set);
+			anc->Cluster |= p->Cluster;
         }
     }
 }
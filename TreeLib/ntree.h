@@ -5,6 +5,7 @@
 
 #include "TreeLib.h"
 #include "gtree.h"
+#include "clusterset.h"
 
 #include <set>
 #include <map>
@@ -28,7 +29,7 @@ public:
 	/**
 	 * A set of indices of all descendants of this node.
 	 */		
-	IntegerSet Cluster;
+	ClusterSet Cluster;
 };
 typedef NNode *NNodePtr;
 
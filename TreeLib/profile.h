@@ -44,7 +44,14 @@
 #include "gtree.h"
 
 #include "treereader.h"
+#include "mappedfile.h"
+#include "newickreader.h"
+#include "profilecache.h"
 #include "treewriter.h"
+#include "threadpool.h"
+#include "nodeiterator.h"
+
+#include <set>
 
 /*
 // NCL includes
@@ -102,7 +109,7 @@ public:
 	/**
 	 * Constructor
 	 */
-	Profile () {};
+	Profile () { LabelNumbers = false; };
 	/**
 	 * Destructor
 	 */
@@ -143,6 +150,19 @@ public:
 	 * @sa Profile::GetIndexOfLabel
 	 */
 	virtual std::string GetLabelFromIndex (int i) { return LabelIndex[i]; };
+	/**
+	 * @brief The leaf labels
+	 * @return The vector of leaf labels, so that the ith element is the
+	 * label with index i
+	 * @sa Profile::GetLabelFromIndex
+	 */
+	virtual const vector<string> &GetLabels () const { return LabelIndex; };
+	/**
+	 * @return true if the label number of each leaf of the trees is already
+	 * the index of its label plus one, as it is for a profile cache
+	 * @sa Profile::ReadCache
+	 */
+	virtual bool HasLabelNumbers () const { return LabelNumbers; };
 
 	/**
 	 * @brief Assign a unique integer index to each leaf label in the profile
@@ -179,6 +199,39 @@ public:
 	 * @return true if successful
 	 */
 	virtual bool ReadTrees (istream &f);
+	/**
+	 * @brief Read a PHYLIP tree file by mapping it into memory
+	 *
+	 * The trees and labels are the same as ReadTrees would give for a stream
+	 * on the file, but the file is read with MappedFile and NewickScanner, so
+	 * large files are read much more quickly.
+	 *
+	 * If pool is not NULL the trees are read in parallel. FindTreeEnds splits
+	 * the text into tree descriptions, and blocks of consecutive trees are
+	 * read by tasks in the pool, each of which also lists the labels in the
+	 * order they first occur in its trees. The blocks are then added in file
+	 * order, so Trees and the label indices are the same as for a serial read.
+	 * If any block has an error the file is read again serially, so that the
+	 * error is reported as before.
+	 *
+	 * If the file is a profile cache it is read with ReadCache.
+	 * @param filename name of the file
+	 * @param pool thread pool, or NULL to read the trees in order
+	 * @return true if successful
+	 */
+	virtual bool ReadTrees (const char *filename, ThreadPool *pool = NULL);
+	/**
+	 * @brief Read the labels and trees from a profile cache
+	 *
+	 * The labels have the same indices as in the profile that was cached, and
+	 * the label number of each leaf is the index of its label plus one.
+	 * @param data the cache, e.g. a mapped file
+	 * @param size the number of bytes in the cache
+	 * @param pool thread pool used to build the trees, or NULL
+	 * @return true if successful
+	 * @sa ProfileCache
+	 */
+	virtual bool ReadCache (const char *data, size_t size, ThreadPool *pool = NULL);
 	/**
 	 * @brief Output leaf labels.
 	 *
@@ -211,6 +264,28 @@ protected:
 	 *
 	 */
 	vector <string> LabelIndex;
+	/**
+	 * True if the leaves of all the trees have their label numbers set
+	 *
+	 */
+	bool LabelNumbers;
+
+	/**
+	 * @struct TreeBlock
+	 * The trees read by one task of ReadTreesInParallel
+	 */
+	struct TreeBlock
+	{
+		size_t			first;		// first tree description in the block
+		size_t			last;		// one past the last
+		vector<T>		trees;
+		vector<string>	labels;		// leaf labels in order of first occurrence
+		bool			ok;			// false if a description could not be read
+	};
+
+	static void ReadBlock (const char *text, const std::vector<size_t> &ends, TreeBlock &block);
+	static void ReadCacheBlock (const ProfileCache &cache, int first, int last, T *trees);
+	virtual bool ReadTreesInParallel (const char *text, const std::vector<size_t> &ends, ThreadPool *pool);
 };
 
 
@@ -560,6 +635,235 @@ template <class T> bool Profile<T>::ReadPHYLIP (istream &f)
 	return result;
 }
 
+//------------------------------------------------------------------------------
+template <class T> bool Profile<T>::ReadTrees (const char *filename, ThreadPool *pool)
+{
+	MappedFile file;
+	if (!file.Open (filename))
+	{
+		cerr << "Unknown error reading data file (check to make sure file exists)" << endl;
+		return false;
+	}
+	if (ProfileCache::IsProfileCache (file.GetData(), file.GetSize()))
+		return ReadCache (file.GetData(), file.GetSize(), pool);
+
+	std::vector<size_t> ends;
+	if ((pool != NULL) && FindTreeEnds (file.GetData(), file.GetSize(), ends)
+		&& (ends.size() > (size_t)pool->GetNumThreads()))
+	{
+		// Anything after the last ";" is read as well, in case it has an error
+		if (ends.back() < file.GetSize())
+			ends.push_back (file.GetSize());
+		if (ReadTreesInParallel (file.GetData(), ends, pool))
+			return (Trees.size() > 0);
+	}
+
+	NewickScanner s (file.GetData(), file.GetSize());
+	NewickReader tr (s);
+	bool ok = true;
+	while (ok)
+	{
+		T t;
+
+		try
+		{
+			ok = tr.Read (&t);
+		}
+		catch (XTokeniser x)
+		{
+#if USE_WXWINDOWS 
+			wxLogError ("%s at line %d, column %d", x.msg.c_str(), x.line, x.col);           
+#elif USE_VC2
+			char buf[256];
+			sprintf (buf, "%s at line %d, column %d", x.msg.c_str(), x.line, x.col);
+			Message (MSG_ERROR, "Error reading tree file", buf);
+#else
+			cerr << x.msg << " (line " << x.line << ", column " << x.col << ")" << endl;
+#endif
+		 	return false;
+		}
+
+		if (ok)
+			Trees.push_back (t);
+	}
+	
+	bool result = (Trees.size() > 0);
+	if (result)
+		MakeLabelList ();
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Read tree descriptions block.first,...,block.last-1. Description k ends at
+// ends[k], and must hold exactly one tree (or none, if it is the text after
+// the last tree).
+template <class T> void Profile<T>::ReadBlock (const char *text, const std::vector<size_t> &ends, TreeBlock &block)
+{
+	block.ok = true;
+	block.trees.reserve (block.last - block.first);
+	std::set<string> seen;
+	size_t start = (block.first == 0) ? 0 : ends[block.first - 1];
+	for (size_t k = block.first; k < block.last; k++)
+	{
+		NewickScanner s (text + start, ends[k] - start);
+		NewickReader tr (s);
+		start = ends[k];
+		T t;
+		try
+		{
+			if (!tr.Read (&t))
+				continue;
+		}
+		catch (XTokeniser x)
+		{
+			block.ok = false;
+			return;
+		}
+		if (s.GetNextToken () != Tokeniser::EMPTY)
+		{
+			block.ok = false;
+			return;
+		}
+
+		// Labels in the order MakeLabelList visits them, i.e. by leaf number
+		vector<string> leaf_labels (t.GetNumLeaves());
+		NodeIterator <Node> n (t.GetRoot());
+		for (Node *q = n.begin(); q; q = n.next())
+		{
+			if (q->IsLeaf())
+				leaf_labels[q->GetLeafNumber() - 1] = q->GetLabel();
+		}
+		for (size_t j = 0; j < leaf_labels.size(); j++)
+		{
+			if (seen.insert (leaf_labels[j]).second)
+				block.labels.push_back (leaf_labels[j]);
+		}
+
+		block.trees.push_back (t);
+	}
+}
+
+//------------------------------------------------------------------------------
+template <class T> bool Profile<T>::ReadTreesInParallel (const char *text, const std::vector<size_t> &ends, ThreadPool *pool)
+{
+	// Split the descriptions into blocks with roughly the same amount of text
+	size_t num_tasks = 4 * pool->GetNumThreads();
+	size_t per_task = ends.back() / num_tasks + 1;
+	vector<TreeBlock> blocks;
+	size_t first = 0;
+	size_t start = 0;
+	for (size_t k = 0; k < ends.size(); k++)
+	{
+		if ((ends[k] - start >= per_task) || (k == ends.size() - 1))
+		{
+			TreeBlock b;
+			b.first = first;
+			b.last = k + 1;
+			blocks.push_back (b);
+			first = k + 1;
+			start = ends[k];
+		}
+	}
+
+	TaskGroup group;
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		TreeBlock *block = &blocks[b];
+		pool->Submit (group, [text, &ends, block] { ReadBlock (text, ends, *block); });
+	}
+	pool->Wait (group);
+
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		if (!blocks[b].ok)
+			return false;
+	}
+
+	// Add the trees and labels in file order
+	size_t num_trees = Trees.size();
+	for (size_t b = 0; b < blocks.size(); b++)
+		num_trees += blocks[b].trees.size();
+	Trees.reserve (num_trees);
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		for (size_t i = 0; i < blocks[b].trees.size(); i++)
+			Trees.push_back (blocks[b].trees[i]);
+		vector<T>().swap (blocks[b].trees);
+
+		for (size_t i = 0; i < blocks[b].labels.size(); i++)
+		{
+			const string &label = blocks[b].labels[i];
+			if (Labels.find (label) == Labels.end ())
+			{
+				int index = Labels.size();
+				Labels[label] = index;
+				LabelIndex.push_back (label);
+			}
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+template <class T> bool Profile<T>::ReadCache (const char *data, size_t size, ThreadPool *pool)
+{
+	ProfileCache cache;
+	bool ok = cache.Attach (data, size);
+	if (ok)
+	{
+		for (int i = 0; i < cache.GetNumLabels(); i++)
+		{
+			string label = cache.GetLabel (i);
+			Labels[label] = i;
+			LabelIndex.push_back (label);
+		}
+		// Each label must be unique
+		ok = (Labels.size() == LabelIndex.size());
+	}
+	if (!ok)
+	{
+		cerr << "Profile cache is damaged, or was written by a different version" << endl;
+		Labels.clear();
+		LabelIndex.clear();
+		return false;
+	}
+
+	int num_trees = cache.GetNumTrees();
+	size_t first = Trees.size();
+	// The cache sets the label numbers of its trees, but not of any trees
+	// that were read before
+	LabelNumbers = (first == 0);
+	Trees.resize (first + num_trees);
+	T *trees = (num_trees > 0) ? &Trees[first] : NULL;
+	if (pool != NULL)
+	{
+		int num_tasks = 4 * pool->GetNumThreads();
+		int per_task = num_trees / num_tasks + 1;
+		TaskGroup group;
+		for (int i = 0; i < num_trees; i += per_task)
+		{
+			int last = min (i + per_task, num_trees);
+			pool->Submit (group, [&cache, i, last, trees] { ReadCacheBlock (cache, i, last, trees); });
+		}
+		pool->Wait (group);
+	}
+	else
+		ReadCacheBlock (cache, 0, num_trees, trees);
+	return (Trees.size() > 0);
+}
+
+//------------------------------------------------------------------------------
+// Build trees first,...,last-1 of the cache
+template <class T> void Profile<T>::ReadCacheBlock (const ProfileCache &cache, int first, int last, T *trees)
+{
+	FlatTree f;
+	for (int i = first; i < last; i++)
+	{
+		cache.GetTree (i, f);
+		f.ToTree (trees[i]);
+	}
+}
+
 //------------------------------------------------------------------------------
 template <class T> void Profile<T>::ShowTrees (ostream &f)
 {
@@ -0,0 +1,335 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "profilecache.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+
+// First bytes of a cache. The first byte is not text, so a tree file cannot
+// be mistaken for a cache.
+static const char signature[8] = { '\x89', 'S', 'T', 'C', 'A', 'C', 'H', 'E' };
+
+// Written as a number, so a cache read with the other byte order has a
+// different value
+#define PROFILE_CACHE_BYTE_ORDER	0x01020304
+
+// Tree flags
+#define TREE_ROOTED					1
+#define TREE_EDGE_LENGTHS			2
+#define TREE_INTERNAL_LABELS		4
+
+struct ProfileCache::Header
+{
+	char				signature[8];
+	unsigned int		version;
+	unsigned int		byte_order;
+	unsigned int		num_labels;
+	unsigned int		num_strings;
+	unsigned int		num_trees;
+	unsigned long long	num_nodes;
+	unsigned long long	trees_offset;
+	unsigned long long	nodes_offset;
+	unsigned long long	strings_offset;		// num_strings + 1 offsets, then the characters
+	unsigned long long	file_size;
+};
+
+struct ProfileCache::TreeRecord
+{
+	unsigned long long	first_node;
+	double				weight;
+	int					num_nodes;
+	int					num_leaves;
+	int					name;				// index of string, or -1 if no name
+	int					flags;
+};
+
+struct ProfileCache::NodeRecord
+{
+	int					parent;				// -1 for the root
+	int					label;				// index of string, or -1 if no label
+	int					leaf_number;
+	int					leaf;				// 1 for a leaf, 0 for an internal node
+	float				length;
+};
+
+// Round up to a multiple of 8 bytes
+static unsigned long long Align (unsigned long long n)
+{
+	return (n + 7) & ~7ULL;
+}
+
+//------------------------------------------------------------------------------
+ProfileCache::ProfileCache ()
+{
+	data				= NULL;
+	size				= 0;
+	num_labels			= 0;
+	num_strings			= 0;
+	num_trees			= 0;
+	string_offsets		= NULL;
+	strings				= NULL;
+	tree_records		= NULL;
+	node_records		= NULL;
+}
+
+//------------------------------------------------------------------------------
+bool ProfileCache::IsProfileCache (const char *data, size_t size)
+{
+	return (size >= sizeof (signature)) && (memcmp (data, signature, sizeof (signature)) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Check that an array of n elements of the given size starting at offset
+// lies within the file
+static bool InFile (unsigned long long offset, unsigned long long n, size_t element, size_t size)
+{
+	if ((offset > size) || (offset % 8 != 0))
+		return false;
+	return (n <= (size - offset) / element);
+}
+
+//------------------------------------------------------------------------------
+bool ProfileCache::Attach (const char *d, size_t s)
+{
+	*this = ProfileCache ();
+	if (!IsProfileCache (d, s) || (s < sizeof (Header)))
+		return false;
+	const Header *h = (const Header *)d;
+	if ((h->version != PROFILE_CACHE_VERSION) || (h->byte_order != PROFILE_CACHE_BYTE_ORDER)
+		|| (h->file_size != s) || (h->num_strings < h->num_labels)
+		|| (h->num_labels > 0x7fffffff) || (h->num_strings > 0x7fffffff) || (h->num_trees > 0x7fffffff))
+		return false;
+	if (!InFile (h->trees_offset, h->num_trees, sizeof (TreeRecord), s)
+		|| !InFile (h->nodes_offset, h->num_nodes, sizeof (NodeRecord), s)
+		|| !InFile (h->strings_offset, (unsigned long long)h->num_strings + 1, sizeof (unsigned long long), s))
+		return false;
+
+	// The characters of the strings follow their offsets
+	const unsigned long long *offsets = (const unsigned long long *)(d + h->strings_offset);
+	unsigned long long chars_offset = h->strings_offset + ((unsigned long long)h->num_strings + 1) * sizeof (unsigned long long);
+	unsigned long long num_chars = s - chars_offset;
+	if (offsets[0] != 0)
+		return false;
+	for (unsigned int i = 0; i < h->num_strings; i++)
+	{
+		if ((offsets[i + 1] < offsets[i]) || (offsets[i + 1] > num_chars))
+			return false;
+	}
+
+	// Each tree must be a set of nodes in preorder, with leaves numbered
+	// 1,...,num_leaves
+	const TreeRecord *trees = (const TreeRecord *)(d + h->trees_offset);
+	const NodeRecord *nodes = (const NodeRecord *)(d + h->nodes_offset);
+	std::vector<char> numbered;
+	for (unsigned int i = 0; i < h->num_trees; i++)
+	{
+		const TreeRecord &r = trees[i];
+		if ((r.num_nodes < 0) || (r.first_node > h->num_nodes)
+			|| ((unsigned long long)r.num_nodes > h->num_nodes - r.first_node)
+			|| (r.num_leaves < 0) || (r.num_leaves > r.num_nodes)
+			|| (r.name < -1) || (r.name >= (int)h->num_strings))
+			return false;
+		numbered.assign (r.num_leaves + 1, 0);
+		int leaves = 0;
+		for (int v = 0; v < r.num_nodes; v++)
+		{
+			const NodeRecord &n = nodes[r.first_node + v];
+			if ((v == 0) ? (n.parent != -1) : ((n.parent < 0) || (n.parent >= v)))
+				return false;
+			if ((n.label < -1) || (n.label >= (int)h->num_strings))
+				return false;
+			if (n.leaf == 1)
+			{
+				if ((n.label < 0) || (n.label >= (int)h->num_labels)
+					|| (n.leaf_number < 1) || (n.leaf_number > r.num_leaves)
+					|| numbered[n.leaf_number])
+					return false;
+				numbered[n.leaf_number] = 1;
+				leaves++;
+			}
+			else if (n.leaf != 0)
+				return false;
+			if ((v > 0) && nodes[r.first_node + n.parent].leaf)
+				return false;
+		}
+		if (leaves != r.num_leaves)
+			return false;
+	}
+
+	data				= d;
+	size				= s;
+	num_labels			= (int)h->num_labels;
+	num_strings			= (int)h->num_strings;
+	num_trees			= (int)h->num_trees;
+	string_offsets		= offsets;
+	strings				= d + chars_offset;
+	tree_records		= trees;
+	node_records		= nodes;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+std::string ProfileCache::GetString (int i) const
+{
+	return std::string (strings + string_offsets[i], strings + string_offsets[i + 1]);
+}
+
+//------------------------------------------------------------------------------
+void ProfileCache::GetTree (int i, FlatTree &t) const
+{
+	t.Clear ();
+	const TreeRecord &r = tree_records[i];
+	if (r.name != -1)
+		t.name = GetString (r.name);
+	t.weight			= r.weight;
+	t.rooted			= (r.flags & TREE_ROOTED) != 0;
+	t.edge_lengths		= (r.flags & TREE_EDGE_LENGTHS) != 0;
+	t.internal_labels	= (r.flags & TREE_INTERNAL_LABELS) != 0;
+
+	t.parent.reserve (r.num_nodes);
+	t.leaf.reserve (r.num_nodes);
+	t.label_number.reserve (r.num_nodes);
+	t.leaf_number.reserve (r.num_nodes);
+	t.label.reserve (r.num_nodes);
+	t.length.reserve (r.num_nodes);
+	const NodeRecord *n = node_records + r.first_node;
+	for (int v = 0; v < r.num_nodes; v++)
+	{
+		bool is_leaf = (n[v].leaf == 1);
+		t.parent.push_back (n[v].parent);
+		t.leaf.push_back (is_leaf ? 1 : 0);
+		t.label_number.push_back (is_leaf ? n[v].label + 1 : 0);
+		t.leaf_number.push_back (n[v].leaf_number);
+		t.label.push_back ((n[v].label == -1) ? std::string () : GetString (n[v].label));
+		t.length.push_back (n[v].length);
+	}
+	t.num_leaves = r.num_leaves;
+	t.LinkNodes ();
+}
+
+//------------------------------------------------------------------------------
+bool ProfileCache::Write (const char *filename, const std::vector<std::string> &labels,
+	const std::vector<FlatTree> &trees)
+{
+	// The labels come first in the strings, then any other names and labels
+	std::vector<std::string> extra;
+	std::map<std::string, int> extra_index;
+
+	std::vector<TreeRecord> tree_records (trees.size());
+	std::vector<NodeRecord> node_records;
+	for (size_t i = 0; i < trees.size(); i++)
+	{
+		const FlatTree &t = trees[i];
+		TreeRecord &r = tree_records[i];
+		memset (&r, 0, sizeof (r));
+		r.first_node	= node_records.size();
+		r.weight		= t.weight;
+		r.num_nodes		= t.GetNumNodes();
+		r.num_leaves	= t.GetNumLeaves();
+		r.flags			= (t.rooted ? TREE_ROOTED : 0) | (t.edge_lengths ? TREE_EDGE_LENGTHS : 0)
+			| (t.internal_labels ? TREE_INTERNAL_LABELS : 0);
+		r.name			= -1;
+
+		// v == -1 is the name of the tree. Leaves use the index of their
+		// label, other strings are added to extra, and empty ones are -1.
+		for (int v = -1; v < t.GetNumNodes(); v++)
+		{
+			const std::string &str = (v == -1) ? t.name : t.label[v];
+			int index = -1;
+			if ((v != -1) && t.leaf[v])
+			{
+				index = t.label_number[v] - 1;
+				if ((index < 0) || (index >= (int)labels.size()) || (labels[index] != str))
+					return false;
+			}
+			else if (str != "")
+			{
+				std::map<std::string, int>::iterator there = extra_index.find (str);
+				if (there == extra_index.end())
+				{
+					index = (int)(labels.size() + extra.size());
+					extra_index[str] = index;
+					extra.push_back (str);
+				}
+				else
+					index = there->second;
+			}
+			if (v == -1)
+			{
+				r.name = index;
+				continue;
+			}
+			NodeRecord n;
+			n.parent		= t.parent[v];
+			n.label			= index;
+			n.leaf_number	= t.leaf_number[v];
+			n.leaf			= t.leaf[v] ? 1 : 0;
+			n.length		= t.length[v];
+			node_records.push_back (n);
+		}
+	}
+
+	Header h;
+	memset (&h, 0, sizeof (h));
+	memcpy (h.signature, signature, sizeof (signature));
+	h.version			= PROFILE_CACHE_VERSION;
+	h.byte_order		= PROFILE_CACHE_BYTE_ORDER;
+	h.num_labels		= (unsigned int)labels.size();
+	h.num_strings		= (unsigned int)(labels.size() + extra.size());
+	h.num_trees			= (unsigned int)trees.size();
+	h.num_nodes			= node_records.size();
+
+	std::vector<unsigned long long> string_offsets (1, 0);
+	for (size_t i = 0; i < labels.size(); i++)
+		string_offsets.push_back (string_offsets.back() + labels[i].size());
+	for (size_t i = 0; i < extra.size(); i++)
+		string_offsets.push_back (string_offsets.back() + extra[i].size());
+
+	h.trees_offset		= Align (sizeof (Header));
+	h.nodes_offset		= Align (h.trees_offset + tree_records.size() * sizeof (TreeRecord));
+	h.strings_offset	= Align (h.nodes_offset + node_records.size() * sizeof (NodeRecord));
+	h.file_size			= h.strings_offset + string_offsets.size() * sizeof (unsigned long long)
+		+ string_offsets.back();
+
+	std::ofstream f (filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!f)
+		return false;
+	const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	f.write ((const char *)&h, sizeof (h));
+	f.write (zeros, h.trees_offset - sizeof (h));
+	if (!tree_records.empty())
+		f.write ((const char *)&tree_records[0], tree_records.size() * sizeof (TreeRecord));
+	f.write (zeros, h.nodes_offset - (h.trees_offset + tree_records.size() * sizeof (TreeRecord)));
+	if (!node_records.empty())
+		f.write ((const char *)&node_records[0], node_records.size() * sizeof (NodeRecord));
+	f.write (zeros, h.strings_offset - (h.nodes_offset + node_records.size() * sizeof (NodeRecord)));
+	f.write ((const char *)&string_offsets[0], string_offsets.size() * sizeof (unsigned long long));
+	for (size_t i = 0; i < labels.size(); i++)
+		f.write (labels[i].data(), labels[i].size());
+	for (size_t i = 0; i < extra.size(); i++)
+		f.write (extra[i].data(), extra[i].size());
+	f.close ();
+	return !f.fail();
+}
@@ -0,0 +1,134 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file profilecache.h
+ *
+ * A binary copy of a profile of trees that can be mapped into memory
+ *
+ */
+
+#ifndef PROFILECACHEH
+#define PROFILECACHEH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "flattree.h"
+
+/**
+ * @def PROFILE_CACHE_VERSION
+ * Version of the cache format. A cache written with a different version is
+ * not read.
+ */
+#define PROFILE_CACHE_VERSION 2
+
+/**
+ * @class ProfileCache
+ * Read access to a profile cache, a binary file holding the leaf labels of
+ * a profile and its trees. Reading a cache needs no parsing, so a profile
+ * that is used many times can be written once with ProfileCache::Write and
+ * then loaded in a fraction of the time it takes to read the tree file.
+ *
+ * The file starts with a header that gives the version and the offsets of
+ * three sections, each of which is an array that is used in place:
+ * - the strings: the leaf labels of the profile in order of their index,
+ *   followed by the tree names and the labels of internal nodes
+ * - one record per tree, giving its first node, weight, name and flags
+ * - one record per node, with the nodes of each tree in preorder. A node
+ *   holds the number of its ancestor, its label as an index into the strings,
+ *   its leaf number, edge length, and whether it is a leaf
+ *
+ * Numbers are stored in the byte order of the machine that wrote the file,
+ * and a cache written on a machine with the other byte order is rejected.
+ */
+class ProfileCache
+{
+public:
+	ProfileCache ();
+
+	/**
+	 * @brief Use a cache held in memory, e.g. in a MappedFile
+	 *
+	 * The data is not copied, and must stay valid while the cache is used.
+	 * @param data the first byte of the cache
+	 * @param size the number of bytes
+	 * @return false if the data is not a cache of this version, or is damaged
+	 */
+	bool Attach (const char *data, size_t size);
+	/**
+	 * @param data the first byte of a file
+	 * @param size the number of bytes
+	 * @return true if the data starts with the signature of a profile cache
+	 */
+	static bool IsProfileCache (const char *data, size_t size);
+
+	int GetNumLabels () const { return num_labels; };
+	/**
+	 * @param i the index of a label, in the range 0 - (GetNumLabels()-1)
+	 * @return the ith leaf label of the profile
+	 */
+	std::string GetLabel (int i) const { return GetString (i); };
+	int GetNumTrees () const { return num_trees; };
+	/**
+	 * @brief Get the ith tree
+	 *
+	 * The label number of each leaf is set to the index of its label plus one.
+	 * @param i the index of the tree
+	 * @param t set to the tree
+	 */
+	void GetTree (int i, FlatTree &t) const;
+
+	/**
+	 * @brief Write a profile cache
+	 *
+	 * @param filename name of the file
+	 * @param labels the leaf labels of the profile, in order of their index
+	 * @param trees the trees, in which the label number of each leaf is
+	 * the index of its label plus one
+	 * @return false if the file could not be written, or a leaf has a label
+	 * number that is out of range
+	 */
+	static bool Write (const char *filename, const std::vector<std::string> &labels,
+		const std::vector<FlatTree> &trees);
+
+protected:
+	struct Header;
+	struct TreeRecord;
+	struct NodeRecord;
+
+	const char					*data;
+	size_t						size;
+	int							num_labels;
+	int							num_strings;
+	int							num_trees;
+	const unsigned long long	*string_offsets;	// num_strings + 1 offsets
+	const char					*strings;
+	const TreeRecord			*tree_records;
+	const NodeRecord			*node_records;
+
+	std::string GetString (int i) const;
+};
+
+#endif
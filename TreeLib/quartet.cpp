@@ -33,9 +33,7 @@
 #include "lcaquery.h"
 
 #include <iomanip>
-#ifdef __GNUC__
-	#include <algorithm>
-#endif
+#include <algorithm>
 
 
 #define DEBUG_QUARTETS 0
@@ -44,7 +42,7 @@
 class ECODE
 {
 public:
-	ECODE (Tree *tree);
+	ECODE (Tree *tree, LCAQuery *query = NULL);
     ~ECODE ();
 	virtual void EncodeNode (NNodePtr r);
     virtual void EncodeTree (int ni, int nj);
@@ -59,7 +57,7 @@ protected:
 	int i;
 	int j;
 	Tree * t;
-    SimpleLCAQuery lca;
+    LCAQuery *lca;
     IntegerSet mVisited;
 };
 
@@ -76,10 +74,12 @@ public:
 
 // Local routines
 
-long n_choose_2 (int n);
-long n_choose_3 (int n);
-long n_choose_4 (int n);
+long long n_choose_2 (int n);
+long long n_choose_3 (int n);
+long long n_choose_4 (int n);
 void RadixSort (ECODE &E1, ECODE &E2, int &s, int &r, int &x);
+void RadixSort (int n, const int *V1, const int *S1, const int *V2, const int *S2,
+	int &s, int &r, int &x);
 
 
 
@@ -136,36 +136,37 @@ public:
 
 
 //------------------------------------------------------------------------------
-long n_choose_2 (int n)
+long long n_choose_2 (int n)
 {
 	if (n < 2)
 		return 0;
 	else
-		return  (n * (n-1)) / 2;
+		return  ((long long)n * (n-1)) / 2;
 }
 
 
 //------------------------------------------------------------------------------
-long n_choose_3 (int n)
+long long n_choose_3 (int n)
 {
 	if (n < 3)
 		return 0;
 	else
-		return  (n * (n-1) * (n-2)) / 6;
+		return  ((long long)n * (n-1) * (n-2)) / 6;
 }
 
 //------------------------------------------------------------------------------
-long n_choose_4 (int n)
+long long n_choose_4 (int n)
 {
 	if (n < 4)
 		return 0;
 	else
-		return  (n * (n-1) * (n-2) * (n-3)) / 24;
+		return  ((long long)n * (n-1) * (n-2) * (n-3)) / 24;
 }
 
 
 //------------------------------------------------------------------------------
-ECODE::ECODE (Tree *tree)
+// query answers LCA queries on tree, and is only needed by EncodeTree
+ECODE::ECODE (Tree *tree, LCAQuery *query)
 {
 	t = tree;
 
@@ -183,7 +184,7 @@ ECODE::ECODE (Tree *tree)
 	}
 	vertex = subtree = 0;
 
-    lca.SetTree (t);
+    lca = query;
 }
 
 //------------------------------------------------------------------------------
@@ -199,7 +200,9 @@ ECODE::~ECODE ()
 // not a subset of {1..i}
 bool ECODE::Visit (NNodePtr p)
 {
-    return (!p->IsMarked() && !(p->Cluster <= mVisited));
+    // Same test as std::set's operator<= (p->Cluster <= mVisited)
+    return (!p->IsMarked() && std::lexicographical_compare (mVisited.begin(), mVisited.end(),
+    	p->Cluster.begin(), p->Cluster.end()));
 /*	SetRelations s = p->ClusterRelationship (Visited);
 	return (!p->IsFlag (NF_MARKED) && (s != rdmpIDENTITY && s != rdmpSUBSET));
 */
@@ -239,8 +242,8 @@ void ECODE::EncodeNode (NNodePtr r)
 		{
 			subtree++;
 
-            IntegerSet::iterator nit = q->Cluster.begin();
-            IntegerSet::iterator nend = q->Cluster.end();
+            ClusterSet::iterator nit = q->Cluster.begin();
+            ClusterSet::iterator nend = q->Cluster.end();
             while (nit != nend)
             {
             	if ((*nit) >= i)
@@ -296,7 +299,7 @@ void ECODE::EncodeTree (int ni, int nj)
 	NNodePtr inode = (NNode *)(*t)[i - 1];
 	NNodePtr jnode = (NNode *)(*t)[j - 1];
 
-    NNodePtr lub = (NNode *)lca.LCA (inode, jnode);
+    NNodePtr lub = (NNode *)lca->LCA (inode, jnode);
     vertex = 1;
 
     mVisited.erase(mVisited.begin(), mVisited.end());
@@ -346,7 +349,7 @@ void ECODE::EncodeTree (int ni, int nj)
 
 	for (int k = i + 1; k <= n; k++)
 	{
-    	bool kIsElement = (q->Cluster.find(k) != q->Cluster.end());
+    	bool kIsElement = (q->Cluster.count (k) != 0);
 		if ((k != j) && !kIsElement)
 		{
 			E[1][k] = vertex;
@@ -394,15 +397,24 @@ void ECODE::Write (ostream &s)
 // Replace original code from Douchette and COMPONENT by a simple use of
 // STL.
 void RadixSort (ECODE &E1, ECODE &E2, int &s, int &r, int &x)
+{
+	RadixSort (E1.GetLeaves (), E1.E[1], E1.E[2], E2.E[1], E2.E[2], s, r, x);
+}
+
+//------------------------------------------------------------------------------
+// V1[i] and S1[i] are the vertex and subtree codes of leaf i (1 <= i <= n)
+// in the first tree, V2 and S2 those in the second tree
+void RadixSort (int n, const int *V1, const int *S1, const int *V2, const int *S2,
+	int &s, int &r, int &x)
 {
 	std::vector <Tuple> E;
-	for (int i = 1; i <= E1.GetLeaves (); i++)
+	for (int i = 1; i <= n; i++)
     {
     	Tuple t;
-        t.Vertex1 = E1.E[1][i];
-        t.Subtree1 = E1.E[2][i];
-        t.Vertex2 = E2.E[1][i];
-        t.Subtree2 = E2.E[2][i];
+        t.Vertex1 = V1[i];
+        t.Subtree1 = S1[i];
+        t.Vertex2 = V2[i];
+        t.Subtree2 = S2[i];
 		E.push_back (t);
     }
 
@@ -588,7 +600,7 @@ void SummaryStats (QTValues &QR)
 	QR.SD = float (2 * QR.d + QR.r1 + QR.r2)/ float (2 * QR.d + 2* QR.s + QR.r1 + QR.r2);
 	QR.EA = float (QR.d + QR.r1 + QR.r2 + QR.u)/ float (QR.n);
 	QR.DC = float (QR.d) / float (QR.n);
-	int tmp = QR.d + QR.s;
+	long long tmp = QR.d + QR.s;
 	if (tmp == 0)
 		QR.SJA = -1;
 	else
@@ -610,6 +622,10 @@ void CompareQuartets (NTree &t1, NTree &t2, QTValues &QR)
 	QR.x1 = 0;
 	QR.u = 0;
 	QR.n = n_choose_4 (t1.GetNumLeaves ());
+
+	// The LCA queries are on the same two trees for every pair of leaves
+	EulerLCAQuery lca1 (&t1);
+	EulerLCAQuery lca2 (&t2);
  	for (int i = 1; i < t1.GetNumLeaves (); i++)
 	{
 		for (int j = i + 1; j <= t1.GetNumLeaves (); j++)
@@ -619,8 +635,8 @@ void CompareQuartets (NTree &t1, NTree &t2, QTValues &QR)
 //            cout << "i=" << i << " (" << t1[i-1]->GetLabel() << ") " << " j=" << j << " (" << t1[j-1]->GetLabel() << ") "<< endl;
 //           cout << "i=" << i << " (" << t2[i-1]->GetLabel() << ") " << " j=" << j << " (" << t2[j-1]->GetLabel() << ") "<< endl;
 
-            ECODE E1 (&t1);
-            ECODE E2 (&t2);
+            ECODE E1 (&t1, &lca1);
+            ECODE E2 (&t2, &lca2);
 
             E1.EncodeTree (i, j);
             E2.EncodeTree (i, j);
@@ -752,3 +768,86 @@ void CompareTriplets (NTree &t1, NTree &t2, QTValues &QR)
  	}
 
 }
+
+//------------------------------------------------------------------------------
+// The flat tree version of TCODE::EncodeTree. The path from leaf j to the root
+// is the chain of ancestors of j, and the subtrees hanging from a node q on
+// the path are the children of q that are not on it.
+static void EncodeTriplets (const FlatTree &t, int jnode, std::vector<int> &V, std::vector<int> &S)
+{
+	std::fill (V.begin(), V.end(), 0);
+	std::fill (S.begin(), S.end(), 0);
+	int vertex = 1;
+	int on_path = jnode;
+	for (int q = t.GetAnc (jnode); q != -1; q = t.GetAnc (q))
+	{
+		int subtree = 0;
+		for (int c = t.GetChild (q); c != -1; c = t.GetSibling (c))
+		{
+			if (c == on_path)
+				continue;
+			subtree++;
+			for (int u = c; u < c + t.GetSize (c); u++)
+			{
+				if (t.IsLeaf (u))
+				{
+					V[t.GetLeafNumber (u)] = vertex;
+					S[t.GetLeafNumber (u)] = subtree;
+				}
+			}
+		}
+		if (subtree)
+			vertex++;
+		on_path = q;
+	}
+}
+
+//------------------------------------------------------------------------------
+void CompareTriplets (const FlatTree &t1, const FlatTree &t2, QTValues &QR)
+{
+	// Clear indices
+	QR.SD = 0.0;
+	QR.EA = 0.0;
+	QR.SJA = 0.0;
+	QR.DC = 0.0;
+	QR.d = 0;
+	QR.s = 0;
+	QR.r1 = 0;
+	QR.r2 = 0;
+	QR.x1 = 0;
+	QR.u = 0;
+	int n = t1.GetNumLeaves ();
+	QR.n = n_choose_3 (n);
+
+	// The node of each leaf number
+	int m = std::max (n, t2.GetNumLeaves ());
+	std::vector<int> leaf1 (m + 1, -1);
+	std::vector<int> leaf2 (m + 1, -1);
+	for (int v = 0; v < t1.GetNumNodes(); v++)
+	{
+		if (t1.IsLeaf (v))
+			leaf1[t1.GetLeafNumber (v)] = v;
+	}
+	for (int v = 0; v < t2.GetNumNodes(); v++)
+	{
+		if (t2.IsLeaf (v))
+			leaf2[t2.GetLeafNumber (v)] = v;
+	}
+
+	std::vector<int> V1 (m + 1), S1 (m + 1), V2 (m + 1), S2 (m + 1);
+ 	for (int j = 1; j <= n; j++)
+	{
+        int SS, RR1, RR2, XX1, XX2;
+
+		EncodeTriplets (t1, leaf1[j], V1, S1);
+		EncodeTriplets (t2, leaf2[j], V2, S2);
+        RadixSort (n, &V1[0], &S1[0], &V2[0], &S2[0], SS, RR1, XX1);
+
+        QR.s += SS;
+        QR.r1 += RR1;
+        QR.x1 += XX1;
+
+        RadixSort (n, &V2[0], &S2[0], &V1[0], &S1[0], SS, RR2, XX2);
+        QR.r2 += RR2;
+ 	}
+}
@@ -49,17 +49,19 @@
 #include <vector>
 
 #include "ntree.h"
+#include "flattree.h"
 
 
-// Values
+// Values. The counts are long long as a tree with n leaves has O(n^3)
+// triplets, more than an int can hold once n is above about 1800.
 typedef struct  {
-	int u;		// unresolved in T1 and T2
-	int d;      // resolved but different
-	int s;      // resolved and same
-	int r1;     // resolved in T1 but not T2
-	int r2;     // resolved in T2 but not T1
-	int x1;     // total resolved in T1
-	int n;      // maximum no. of quartets/triplets
+	long long u;	// unresolved in T1 and T2
+	long long d;	// resolved but different
+	long long s;	// resolved and same
+	long long r1;	// resolved in T1 but not T2
+	long long r2;	// resolved in T2 but not T1
+	long long x1;	// total resolved in T1
+	long long n;	// maximum no. of quartets/triplets
 	float SD;   // symmetric difference
 	float EA;   // explicitly agree
 	float SJA;  // strict joint assertions
@@ -72,6 +74,12 @@ void ShowHeader (ostream &s);
 void ShowQTRecord (ostream &s, QTValues &QR);
 void CompareQuartets (NTree &t1, NTree &t2, QTValues &QR);
 void CompareTriplets (NTree &t1, NTree &t2, QTValues &QR);
+/**
+ * Compare the triplets in two flat trees, as CompareTriplets for NTree does.
+ * The leaves of both trees must be numbered 1,...,n by their leaf numbers,
+ * with the same number for the same taxon.
+ */
+void CompareTriplets (const FlatTree &t1, const FlatTree &t2, QTValues &QR);
 
 
 
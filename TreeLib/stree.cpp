@@ -61,3 +61,26 @@ void STree::AddSubtree (Tree &T, bool asChild)
     Leaves += T.GetNumLeaves ();
     CurNode = p;
 }
+
+void STree::GraftTree (STree &T)
+{
+	NodePtr r = T.GetRoot();
+
+	CurNode->AppendLabel (r->GetLabel());
+	CurNode->SetDegree (r->GetDegree());
+	CurNode->AddWeight (r->GetWeight());
+
+	NodePtr q = r->GetChild();
+	CurNode->SetChild (q);
+	while (q)
+	{
+		q->SetAnc (CurNode);
+		q = q->GetSibling();
+	}
+	r->SetChild (NULL);
+
+	Leaves += T.Leaves;
+	Internals += T.Internals;
+	T.Leaves = 0;
+	T.Internals = 0;
+}
@@ -32,6 +32,14 @@ public:
 	 * @param T the subtree
   	 */
     virtual void AddSubtree (Tree &T, bool asChild);
+	/**
+	 * Move the tree T into this tree, so that the root of T becomes CurNode.
+	 * The children of T's root become children of CurNode, and CurNode takes
+	 * the label, degree and weight of T's root. T is left with just its root.
+	 * Leaf numbers in T are not changed.
+	 * @param T the tree to graft
+	 */
+	virtual void GraftTree (STree &T);
 	/**
 	 * Put CurNode onto the stack on nodes
 	 * @param label leaf label
@@ -0,0 +1,159 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "threadpool.h"
+
+// Which pool (if any) the current thread works for, and its queue in that pool.
+// Threads that are not workers (e.g., the thread that made the pool) use queue 0.
+static thread_local const ThreadPool *worker_pool = NULL;
+static thread_local int worker_index = 0;
+
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool (int n)
+{
+	if (n < 1)
+		n = 1;
+	num_threads = n;
+	queued = 0;
+	done = false;
+	for (int i = 0; i < num_threads; i++)
+		queues.push_back (new Queue);
+	// Queue 0 belongs to the calling thread, so we start n-1 workers
+	for (int i = 1; i < num_threads; i++)
+		workers.push_back (std::thread (&ThreadPool::WorkerLoop, this, i));
+}
+
+//------------------------------------------------------------------------------
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard<std::mutex> lk (sleep_lock);
+		done = true;
+	}
+	wake.notify_all ();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join ();
+	for (size_t i = 0; i < queues.size(); i++)
+		delete queues[i];
+}
+
+//------------------------------------------------------------------------------
+int ThreadPool::GetQueueIndex () const
+{
+	return (worker_pool == this) ? worker_index : 0;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::Submit (TaskGroup &g, std::function<void()> task)
+{
+	g.pending++;
+	Queue *q = queues[GetQueueIndex ()];
+	{
+		std::lock_guard<std::mutex> lk (q->lock);
+		Task t;
+		t.fn = task;
+		t.group = &g;
+		q->tasks.push_back (t);
+	}
+	{
+		// Count the task while holding sleep_lock so that a thread about to
+		// sleep can't miss it
+		std::lock_guard<std::mutex> lk (sleep_lock);
+		queued++;
+	}
+	wake.notify_all ();
+}
+
+//------------------------------------------------------------------------------
+// Run one task, taken from the back of our own queue or stolen from the
+// front of another queue. Returns false if there was nothing to do.
+bool ThreadPool::RunOne (int self)
+{
+	Task t;
+	bool found = false;
+	for (int i = 0; i < num_threads && !found; i++)
+	{
+		Queue *q = queues[(self + i) % num_threads];
+		std::lock_guard<std::mutex> lk (q->lock);
+		if (!q->tasks.empty())
+		{
+			if (i == 0)
+			{
+				t = q->tasks.back();
+				q->tasks.pop_back();
+			}
+			else
+			{
+				t = q->tasks.front();
+				q->tasks.pop_front();
+			}
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+	queued--;
+
+	t.fn ();
+
+	bool finished;
+	{
+		std::lock_guard<std::mutex> lk (sleep_lock);
+		finished = (--t.group->pending == 0);
+	}
+	if (finished)
+		wake.notify_all ();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::WorkerLoop (int self)
+{
+	worker_pool = this;
+	worker_index = self;
+	for (;;)
+	{
+		if (!RunOne (self))
+		{
+			std::unique_lock<std::mutex> lk (sleep_lock);
+			wake.wait (lk, [this] { return done || (queued > 0); });
+			if (done)
+				return;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::Wait (TaskGroup &g)
+{
+	int self = GetQueueIndex ();
+	while (g.pending > 0)
+	{
+		if (!RunOne (self))
+		{
+			// Everything left in g is being run by other threads
+			std::unique_lock<std::mutex> lk (sleep_lock);
+			wake.wait (lk, [this, &g] { return (g.pending == 0) || (queued > 0); });
+		}
+	}
+}
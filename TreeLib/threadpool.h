@@ -0,0 +1,119 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file threadpool.h
+ *
+ * A small work-stealing thread pool
+ *
+ */
+
+#ifndef THREADPOOLH
+#define THREADPOOLH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskGroup
+ * A set of tasks submitted to a ThreadPool that are waited for together.
+ * A task may itself submit tasks (in its own group) and wait for them.
+ */
+class TaskGroup
+{
+public:
+	TaskGroup () : pending (0) {};
+	/**
+	 * Number of tasks in the group that have not yet finished
+	 */
+	std::atomic<int> pending;
+};
+
+/**
+ * @class ThreadPool
+ * A fixed set of threads that run tasks. Each thread has its own queue of tasks.
+ * A thread takes work from the back of its own queue (so nested tasks run depth
+ * first, as they would in a serial recursion), and when that queue is empty it
+ * steals from the front of another thread's queue, where the oldest (and
+ * usually largest) tasks are.
+ *
+ * The thread that creates the pool counts as one of its threads. It does
+ * not run tasks until it calls Wait, when it helps with the work until
+ * its group has finished.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * Create a pool of n threads (including the calling thread).
+	 * @param n number of threads
+	 */
+	ThreadPool (int n);
+	virtual ~ThreadPool ();
+	/**
+	 * @return the number of threads in the pool
+	 */
+	virtual int GetNumThreads () const { return num_threads; };
+	/**
+	 * Queue a task. The task is put on the queue of the calling thread.
+	 * @param g the group the task belongs to
+	 * @param task the task
+	 */
+	virtual void Submit (TaskGroup &g, std::function<void()> task);
+	/**
+	 * Run tasks until all the tasks in g have finished.
+	 * @param g the group
+	 */
+	virtual void Wait (TaskGroup &g);
+
+protected:
+	struct Task
+	{
+		std::function<void()>	fn;
+		TaskGroup				*group;
+	};
+	struct Queue
+	{
+		std::mutex				lock;
+		std::deque<Task>		tasks;
+	};
+
+	int GetQueueIndex () const;
+	bool RunOne (int self);
+	void WorkerLoop (int self);
+
+	int							num_threads;
+	std::vector<Queue *>		queues;
+	std::vector<std::thread>	workers;
+	std::mutex					sleep_lock;
+	std::condition_variable		wake;
+	std::atomic<int>			queued;
+	bool						done;
+};
+
+#endif
@@ -0,0 +1,583 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+#include "triplets.h"
+
+#include <algorithm>
+#include <vector>
+
+// In quartet.cpp
+long long n_choose_3 (int n);
+
+typedef long long count_t;
+
+//------------------------------------------------------------------------------
+static inline count_t Pairs (count_t k)
+{
+	return k * (k - 1) / 2;
+}
+
+/**
+ * @class Fenwick
+ * Sums of ranges of an array, with point updates, in O(log n) time.
+ */
+class Fenwick
+{
+public:
+	void Init (int n) { tree.assign (n + 1, 0); };
+	void Add (int i, count_t d)
+	{
+		for (i++; i < (int)tree.size(); i += i & (-i))
+			tree[i] += d;
+	};
+	/**
+	 * @return the sum of elements a,...,b
+	 */
+	count_t Sum (int a, int b) const
+	{
+		return (a > b) ? 0 : Prefix (b) - Prefix (a - 1);
+	};
+protected:
+	count_t Prefix (int i) const
+	{
+		count_t s = 0;
+		for (i++; i > 0; i -= i & (-i))
+			s += tree[i];
+		return s;
+	};
+	std::vector<count_t> tree;
+};
+
+/**
+ * @class LeafSet
+ * A set D of leaves of a tree t, held so that the number of pairs {a,b} of D
+ * that form the triplet ab|c with a leaf c not in D, and the number that form
+ * an unresolved triplet with c, can be found quickly.
+ *
+ * The nodes of t are split into heavy paths, each node being followed on its
+ * path by its child with the largest subtree. The path from a leaf to the root
+ * leaves a heavy path by a light edge at most O(log n) times. For each node x
+ * we keep light[x], the number of leaves of D below x but not below the heavy
+ * child of x (for a leaf, 1 if it is in D), so that the number of leaves of D
+ * below x is the sum of light over x and the nodes below it on its heavy path.
+ * The pairs whose triplet with c is decided at x, where the path from c goes
+ * through the heavy child of x, depend only on the light children of x, and are
+ * summed along heavy paths in Fenwick trees. Inserting a leaf changes these
+ * sums only where its path to the root enters a heavy path.
+ */
+class LeafSet
+{
+public:
+	LeafSet (const FlatTree &tree);
+
+	/**
+	 * Add (delta = 1) or remove (delta = -1) leaf l.
+	 */
+	void Insert (int l, int delta);
+	/**
+	 * @return the number of leaves of D below node v
+	 */
+	count_t Count (int v) const { return light_tree.Sum (pos[v], end[head[v]]); };
+	count_t Size () const { return num; };
+	/**
+	 * For a leaf c not in D, count the pairs {a,b} in D for which t has the
+	 * triplet ab|c (resolved), and those for which a, b and c meet at one node
+	 * (star).
+	 */
+	void Query (int c, count_t &resolved, count_t &star) const;
+	int LCA (int a, int b) const;
+	/**
+	 * @return the child of x that is on the path to its descendant w
+	 */
+	int ChildToward (int x, int w) const;
+	int GetDepth (int v) const { return depth[v]; };
+
+protected:
+	const FlatTree		&t;
+	std::vector<int>	heavy;
+	std::vector<int>	head;
+	std::vector<int>	pos;		// position in the heavy path order
+	std::vector<int>	end;		// for the head of a path, the position of its last node
+	std::vector<int>	depth;
+	std::vector<count_t> light;
+	// Number of pairs of D below the same light child of x
+	std::vector<count_t> light_pairs;
+	Fenwick				light_tree;
+	Fenwick				resolved_tree;
+	Fenwick				star_tree;
+	count_t				num;
+};
+
+//------------------------------------------------------------------------------
+LeafSet::LeafSet (const FlatTree &tree) : t(tree)
+{
+	int n = t.GetNumNodes();
+	heavy.assign (n, -1);
+	head.assign (n, 0);
+	pos.assign (n, 0);
+	end.assign (n, 0);
+	depth.assign (n, 0);
+	light.assign (n, 0);
+	light_pairs.assign (n, 0);
+	num = 0;
+	light_tree.Init (n);
+	resolved_tree.Init (n);
+	star_tree.Init (n);
+
+	for (int v = 0; v < n; v++)
+	{
+		if (t.GetAnc (v) != -1)
+			depth[v] = depth[t.GetAnc (v)] + 1;
+		for (int c = t.GetChild (v); c != -1; c = t.GetSibling (c))
+		{
+			if ((heavy[v] == -1) || (t.GetSize (c) > t.GetSize (heavy[v])))
+				heavy[v] = c;
+		}
+	}
+
+	// Number the nodes so that each heavy path is a run of positions, from
+	// the top down, by visiting the heavy child of a node next
+	std::vector<int> stack;
+	if (n > 0)
+		stack.push_back (0);
+	int next = 0;
+	while (!stack.empty())
+	{
+		int v = stack.back();
+		stack.pop_back();
+		pos[v] = next++;
+		int a = t.GetAnc (v);
+		head[v] = ((a != -1) && (heavy[a] == v)) ? head[a] : v;
+		end[head[v]] = pos[v];
+		for (int c = t.GetChild (v); c != -1; c = t.GetSibling (c))
+		{
+			if (c != heavy[v])
+				stack.push_back (c);
+		}
+		if (heavy[v] != -1)
+			stack.push_back (heavy[v]);
+	}
+}
+
+//------------------------------------------------------------------------------
+void LeafSet::Insert (int l, int delta)
+{
+	num += delta;
+	light[l] += delta;
+	light_tree.Add (pos[l], delta);
+
+	// Go up the light edges on the path to the root. Below x everything
+	// has already been updated, so Count (y) includes l.
+	int y = head[l];
+	while (t.GetAnc (y) != -1)
+	{
+		int x = t.GetAnc (y);
+		count_t k = Count (y);
+		count_t d_pairs = Pairs (k) - Pairs (k - delta);
+		count_t d_star = Pairs (light[x] + delta) - Pairs (light[x]) - d_pairs;
+		light[x] += delta;
+		light_pairs[x] += d_pairs;
+		light_tree.Add (pos[x], delta);
+		resolved_tree.Add (pos[x], d_pairs);
+		star_tree.Add (pos[x], d_star);
+		y = head[x];
+	}
+}
+
+//------------------------------------------------------------------------------
+void LeafSet::Query (int c, count_t &resolved, count_t &star) const
+{
+	resolved = 0;
+	star = 0;
+	int v = c;
+	for (;;)
+	{
+		// Ancestors of v on its heavy path, where the path from c goes through
+		// the heavy child
+		int h = head[v];
+		resolved += resolved_tree.Sum (pos[h], pos[v] - 1);
+		star += star_tree.Sum (pos[h], pos[v] - 1);
+
+		// The ancestor x where the path from c enters by a light edge
+		int x = t.GetAnc (h);
+		if (x == -1)
+			break;
+		count_t in_h = Count (h);
+		count_t in_heavy = Count (heavy[x]);
+		count_t not_h = light[x] + in_heavy - in_h;
+		count_t same_child = light_pairs[x] + Pairs (in_heavy) - Pairs (in_h);
+		resolved += same_child;
+		star += Pairs (not_h) - same_child;
+		v = x;
+	}
+}
+
+//------------------------------------------------------------------------------
+int LeafSet::LCA (int a, int b) const
+{
+	while (head[a] != head[b])
+	{
+		if (depth[head[a]] > depth[head[b]])
+			a = t.GetAnc (head[a]);
+		else
+			b = t.GetAnc (head[b]);
+	}
+	return (depth[a] < depth[b]) ? a : b;
+}
+
+//------------------------------------------------------------------------------
+int LeafSet::ChildToward (int x, int w) const
+{
+	while (head[w] != head[x])
+	{
+		int h = head[w];
+		if (t.GetAnc (h) == x)
+			return h;
+		w = t.GetAnc (h);
+	}
+	return heavy[x];
+}
+
+/**
+ * @class TripletCounter
+ * Counts the triplets resolved in t1 that are resolved in the same way in t2,
+ * and those that are unresolved in t2.
+ */
+class TripletCounter
+{
+public:
+	TripletCounter (const FlatTree &tree1, const FlatTree &tree2, const std::vector<int> &m);
+	void Run ();
+	count_t same;
+	count_t star;
+protected:
+	const FlatTree			&t1;
+	const FlatTree			&t2;
+	// the leaf of t2 that matches each leaf of t1
+	const std::vector<int>	&match;
+	std::vector<int>		leaves;		// number of leaves below each node of t1
+	LeafSet					D;
+
+	void Finish (int u, int h, bool keep);
+	void CountPairs (std::vector<int> &L);
+};
+
+//------------------------------------------------------------------------------
+TripletCounter::TripletCounter (const FlatTree &tree1, const FlatTree &tree2,
+	const std::vector<int> &m) : t1(tree1), t2(tree2), match(m), D(tree2)
+{
+	same = star = 0;
+	leaves.assign (t1.GetNumNodes(), 0);
+	for (int v = t1.GetNumNodes() - 1; v >= 0; v--)
+	{
+		if (t1.IsLeaf (v))
+			leaves[v]++;
+		if (t1.GetAnc (v) != -1)
+			leaves[t1.GetAnc (v)] += leaves[v];
+	}
+}
+
+/**
+ * @struct CounterFrame
+ * A node u of t1 on the stack in TripletCounter::Run. Once the children of u
+ * have been pushed, expanded is true and h is the child with the most leaves
+ * (or -1 if u has no children).
+ */
+struct CounterFrame
+{
+	int		u;
+	int		h;
+	bool	keep;
+	bool	expanded;
+
+	CounterFrame (int v, bool k) { u = v; h = -1; keep = k; expanded = false; };
+};
+
+//------------------------------------------------------------------------------
+// Count the triplets ab|c of t1 at each internal node u, where the three leaves
+// meet. The children of u other than h (the one with the most leaves) are done
+// first, each leaving D empty, then h, which leaves its leaves in D, then u.
+// This is done with a stack rather than by recursion as t1 may be very deep.
+void TripletCounter::Run ()
+{
+	if (t1.GetNumNodes() == 0)
+		return;
+
+	std::vector<CounterFrame> stack;
+	std::vector<int> light;
+	stack.push_back (CounterFrame (0, false));
+	while (!stack.empty())
+	{
+		CounterFrame f = stack.back();
+		if (t1.IsLeaf (f.u))
+		{
+			if (f.keep)
+				D.Insert (match[f.u], 1);
+			stack.pop_back();
+		}
+		else if (!f.expanded)
+		{
+			// Push h, then the other children in reverse, so that they
+			// are taken in order and h comes last
+			int h = -1;
+			light.clear();
+			for (int c = t1.GetChild (f.u); c != -1; c = t1.GetSibling (c))
+			{
+				if ((h == -1) || (leaves[c] > leaves[h]))
+					h = c;
+			}
+			for (int c = t1.GetChild (f.u); c != -1; c = t1.GetSibling (c))
+			{
+				if (c != h)
+					light.push_back (c);
+			}
+			stack.back().h = h;
+			stack.back().expanded = true;
+			if (h != -1)
+				stack.push_back (CounterFrame (h, true));
+			for (size_t k = light.size(); k > 0; k--)
+				stack.push_back (CounterFrame (light[k - 1], false));
+		}
+		else
+		{
+			stack.pop_back();
+			Finish (f.u, f.h, f.keep);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// The children of u have been done, and D holds the leaves below h. Count the
+// triplets whose three leaves meet at u. On return, if keep is true D holds the
+// leaves below u, otherwise it is empty.
+void TripletCounter::Finish (int u, int h, bool keep)
+{
+	// The leaves of the other children of u, grouped by child
+	std::vector<int> W;
+	std::vector<size_t> group;
+	for (int c = t1.GetChild (u); c != -1; c = t1.GetSibling (c))
+	{
+		if (c == h)
+			continue;
+		group.push_back (W.size());
+		for (int v = c; v < c + t1.GetSize (c); v++)
+		{
+			if (t1.IsLeaf (v))
+				W.push_back (match[v]);
+		}
+	}
+	group.push_back (W.size());
+
+	// Pairs below h, with the third leaf below another child
+	for (size_t k = 0; k < W.size(); k++)
+	{
+		count_t r, s;
+		D.Query (W[k], r, s);
+		same += r;
+		star += s;
+	}
+	for (size_t k = 0; k < W.size(); k++)
+		D.Insert (W[k], 1);
+
+	// Pairs below each other child, with the third leaf anywhere else below u
+	std::vector<int> L;
+	for (size_t g = 0; g + 1 < group.size(); g++)
+	{
+		L.assign (W.begin() + group[g], W.begin() + group[g + 1]);
+		CountPairs (L);
+	}
+
+	if (!keep)
+	{
+		for (int v = u; v < u + t1.GetSize (u); v++)
+		{
+			if (t1.IsLeaf (v))
+				D.Insert (match[v], -1);
+		}
+	}
+}
+
+/**
+ * @struct VirtualNode
+ * A node of the subtree of t2 induced by a set of leaves L, while it is on
+ * the stack in CountPairs. k is the number of leaves of L below the children
+ * of the node that have been found so far, k2 the sum of their squares, and
+ * a1 and a2 the sums of k_i * o_i and k_i^2 * o_i, where o_i is the number
+ * of other leaves of D below the child of the node in t2 that leads to child i.
+ */
+struct VirtualNode
+{
+	int		node;
+	count_t	k;
+	count_t	k2;
+	count_t	a1;
+	count_t	a2;
+
+	VirtualNode (int v) { node = v; k = k2 = a1 = a2 = 0; };
+};
+
+//------------------------------------------------------------------------------
+// L is the leaves of t2 below a child of the current node of t1, and D holds
+// the leaves below the current node. For each pair {a,b} of L, count the leaves
+// c of D - L for which t2 has ab|c, or no resolution. The pairs are grouped by
+// their LCA x in t2, i.e. the nodes of the subtree of t2 induced by L, which
+// is built on a stack from the leaves in preorder.
+void TripletCounter::CountPairs (std::vector<int> &L)
+{
+	if (L.size() < 2)
+		return;
+	std::sort (L.begin(), L.end());
+	count_t others = D.Size() - (count_t)L.size();
+
+	std::vector<VirtualNode> stack;
+	stack.push_back (VirtualNode (L[0]));
+	int last = -1;
+	count_t last_k = 0;
+	for (size_t i = 1; i <= L.size(); i++)
+	{
+		// Pop the nodes that are not ancestors of the next leaf (all of
+		// them after the last leaf), attaching each to the one below it
+		int l = (i < L.size()) ? D.LCA (L[i], stack.back().node) : -1;
+		last = -1;
+		while (!stack.empty() && ((l == -1) || (D.GetDepth (stack.back().node) > D.GetDepth (l))))
+		{
+			VirtualNode x = stack.back();
+			stack.pop_back();
+			if (last != -1)
+			{
+				int ch = D.ChildToward (x.node, last);
+				count_t o = D.Count (ch) - last_k;
+				x.k += last_k;
+				x.k2 += last_k * last_k;
+				x.a1 += last_k * o;
+				x.a2 += last_k * last_k * o;
+			}
+
+			// Pairs from different children of x
+			count_t pairs = (x.k * x.k - x.k2) / 2;
+			if (pairs > 0)
+			{
+				count_t o = D.Count (x.node) - x.k;
+				same += pairs * (others - o);
+				star += pairs * o - (x.k * x.a1 - x.a2);
+			}
+			last = x.node;
+			last_k = t2.IsLeaf (x.node) ? 1 : x.k;
+		}
+		if (l == -1)
+			break;
+
+		if (stack.empty() || (stack.back().node != l))
+			stack.push_back (VirtualNode (l));
+		if (last != -1)
+		{
+			VirtualNode &x = stack.back();
+			int ch = D.ChildToward (x.node, last);
+			count_t o = D.Count (ch) - last_k;
+			x.k += last_k;
+			x.k2 += last_k * last_k;
+			x.a1 += last_k * o;
+			x.a2 += last_k * last_k * o;
+		}
+		stack.push_back (VirtualNode (L[i]));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Number of triplets resolved by t
+static count_t ResolvedTriplets (const FlatTree &t)
+{
+	std::vector<count_t> leaves (t.GetNumNodes(), 0);
+	count_t result = 0;
+	for (int v = t.GetNumNodes() - 1; v >= 0; v--)
+	{
+		if (t.IsLeaf (v))
+			leaves[v] = 1;
+		for (int c = t.GetChild (v); c != -1; c = t.GetSibling (c))
+			leaves[v] += leaves[c];
+		for (int c = t.GetChild (v); c != -1; c = t.GetSibling (c))
+			result += Pairs (leaves[c]) * (leaves[v] - leaves[c]);
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------
+void CompareTripletsFast (const FlatTree &t1, const FlatTree &t2, QTValues &QR)
+{
+	// Match the leaves by leaf number
+	int n = t1.GetNumLeaves ();
+	bool ok = (t2.GetNumLeaves () == n);
+	std::vector<int> leaf2 (n + 1, -1);
+	std::vector<int> match (t1.GetNumNodes(), -1);
+	for (int v = 0; ok && (v < t2.GetNumNodes()); v++)
+	{
+		if (t2.IsLeaf (v))
+		{
+			int k = t2.GetLeafNumber (v);
+			if ((k < 1) || (k > n) || (leaf2[k] != -1))
+				ok = false;
+			else
+				leaf2[k] = v;
+		}
+	}
+	for (int v = 0; ok && (v < t1.GetNumNodes()); v++)
+	{
+		if (t1.IsLeaf (v))
+		{
+			int k = t1.GetLeafNumber (v);
+			if ((k < 1) || (k > n) || (leaf2[k] == -1))
+				ok = false;
+			else
+			{
+				match[v] = leaf2[k];
+				leaf2[k] = -1;
+			}
+		}
+	}
+	if (!ok)
+	{
+		CompareTriplets (t1, t2, QR);
+		return;
+	}
+
+	TripletCounter counter (t1, t2, match);
+	counter.Run ();
+	count_t x1 = ResolvedTriplets (t1);
+	count_t x2 = ResolvedTriplets (t2);
+
+	// Clear indices
+	QR.SD = 0.0;
+	QR.EA = 0.0;
+	QR.SJA = 0.0;
+	QR.DC = 0.0;
+	QR.d = 0;
+	QR.u = 0;
+	QR.n = n_choose_3 (n);
+	QR.s = counter.same;
+	QR.r1 = counter.star;
+	QR.x1 = x1;
+	// Triplets resolved in t2 are either the same as in t1, different, or
+	// unresolved in t1
+	count_t d = x1 - counter.same - counter.star;
+	QR.r2 = x2 - counter.same - d;
+}
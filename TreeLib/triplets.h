@@ -0,0 +1,60 @@
+/*
+ * TreeLib
+ * A library for manipulating phylogenetic trees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+ // $Id$
+
+/**
+ * @file triplets.h
+ *
+ * Count the triplets shared by two trees in O(n log^3 n) time
+ *
+ */
+
+#ifndef TRIPLETSH
+#define TRIPLETSH
+
+#include "flattree.h"
+#include "quartet.h"
+
+/**
+ * @fn void CompareTripletsFast (const FlatTree &t1, const FlatTree &t2, QTValues &QR)
+ * @brief compare the triplets in two trees
+ *
+ * Sets the same fields of QR as CompareTriplets (s, r1, r2, x1 and n, with the
+ * others zero), so SummaryStats can be called on the result. The leaves of both
+ * trees must be numbered 1,...,n by their leaf numbers, with the same number
+ * for the same taxon. If they are not, CompareTriplets is used instead.
+ *
+ * CompareTriplets encodes both trees once for every leaf, which takes
+ * O(n^2 log n) time. Here each triplet resolved in t1 is counted at the node
+ * of t1 where its three paths meet, using the "smaller half" trick of Brodal
+ * et al. (2013): the leaves below the largest child of a node are kept in a
+ * structure over t2 as we go up t1, and only the leaves of the other children
+ * are inserted and queried. The structure uses a heavy path decomposition of
+ * t2, so each insertion or query takes O(log^2 n) time, and each leaf is
+ * inserted O(log n) times. Pairs of leaves from a smaller child are counted
+ * on their induced subtree in t2. Triplets resolved in both trees, and those
+ * resolved in t1 but not in t2, are counted this way, and the other values
+ * follow from the number of triplets each tree resolves.
+ */
+void CompareTripletsFast (const FlatTree &t1, const FlatTree &t2, QTValues &QR);
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "cooccurrence.h"
+
+#include <algorithm>
+
+#include "clusterset.h"
+
+//------------------------------------------------------------------------------
+void CoOccurrence::SetTaxa (const std::vector< std::vector<int> > &taxa, int num_taxa)
+{
+	tree_taxa = taxa;
+	ntax = num_taxa;
+}
+
+//------------------------------------------------------------------------------
+void CoOccurrence::Build ()
+{
+	std::call_once (built, &CoOccurrence::BuildBitsets, this);
+}
+
+//------------------------------------------------------------------------------
+void CoOccurrence::BuildBitsets ()
+{
+	size_t num_trees = tree_taxa.size();
+	words = num_trees / 64 + 1;
+	trees.assign ((size_t)ntax * words, 0);
+	first.assign (ntax, words);
+	last.assign (ntax, 0);
+	double pairs = 0.0;
+	for (size_t i = 0; i < num_trees; i++)
+	{
+		size_t w = i / 64;
+		unsigned long long bit = 1ULL << (i % 64);
+		for (size_t t = 0; t < tree_taxa[i].size(); t++)
+		{
+			int id = tree_taxa[i][t] - 1;
+			trees[id * words + w] |= bit;
+			first[id] = std::min (first[id], w);
+			last[id] = w + 1;
+		}
+		double n = (double)tree_taxa[i].size();
+		pairs += n * (n - 1.0) / 2.0;
+	}
+
+	if (ntax <= COOCCURRENCE_DENSE_LIMIT)
+	{
+		matrix.assign ((size_t)ntax * ntax, 0);
+		double comparisons = (double)ntax * (ntax - 1.0) / 2.0 * (double)words;
+		if (pairs < comparisons)
+		{
+			// Count the pairs of taxa in each tree
+			for (size_t i = 0; i < num_trees; i++)
+			{
+				const std::vector<int> &taxa = tree_taxa[i];
+				for (size_t a = 0; a < taxa.size(); a++)
+				{
+					int *row = &matrix[0] + (size_t)(taxa[a] - 1) * ntax;
+					for (size_t b = 0; b < taxa.size(); b++)
+						row[taxa[b] - 1]++;
+				}
+			}
+		}
+		else
+		{
+			for (int id1 = 0; id1 < ntax; id1++)
+			{
+				for (int id2 = id1 + 1; id2 < ntax; id2++)
+				{
+					int n = CountShared (id1, id2);
+					matrix[(size_t)id1 * ntax + id2] = n;
+					matrix[(size_t)id2 * ntax + id1] = n;
+				}
+			}
+		}
+	}
+	std::vector< std::vector<int> >().swap (tree_taxa);
+}
+
+//------------------------------------------------------------------------------
+int CoOccurrence::CountShared (int id1, int id2) const
+{
+	const unsigned long long *a = &trees[0] + id1 * words;
+	const unsigned long long *b = &trees[0] + id2 * words;
+	size_t from = std::max (first[id1], first[id2]);
+	size_t to = std::min (last[id1], last[id2]);
+	int result = 0;
+	for (size_t w = from; w < to; w++)
+		result += ClusterSet::PopCount (a[w] & b[w]);
+	return result;
+}
+
+//------------------------------------------------------------------------------
+int CoOccurrence::GetFreq (int id1, int id2) const
+{
+	if ((id1 < 0) || (id2 < 0) || (id1 >= ntax) || (id2 >= ntax) || (id1 == id2))
+		return 0;
+	if (!matrix.empty())
+		return matrix[(size_t)id1 * ntax + id2];
+	return CountShared (id1, id2);
+}
@@ -0,0 +1,97 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file cooccurrence.h
+ *
+ * The number of input trees in which pairs of taxa occur together
+ *
+ */
+
+#ifndef COOCCURRENCEH
+#define COOCCURRENCEH
+
+#include <mutex>
+#include <vector>
+
+/**
+ * @def COOCCURRENCE_DENSE_LIMIT
+ * The largest number of taxa for which CoOccurrence keeps a matrix of the
+ * counts for all pairs of taxa.
+ */
+#define COOCCURRENCE_DENSE_LIMIT 2048
+
+/**
+ * @class CoOccurrence
+ * Answers freq_co(a,b), the number of input trees that contain both taxa
+ * a and b. For each taxon a bitset records the trees that contain it, and
+ * freq_co(a,b) is the popcount of the AND of the bitsets of a and b. If there
+ * are no more than COOCCURRENCE_DENSE_LIMIT taxa the counts for all pairs are
+ * computed once and kept in a matrix.
+ *
+ * SetTaxa just stores the taxa of the trees. The bitsets are built by the
+ * first call to Build, so they cost nothing if they are not used. Build may
+ * be called by several threads at once, and after it has returned GetFreq
+ * only reads the counts.
+ */
+class CoOccurrence
+{
+public:
+	CoOccurrence () { ntax = 0; words = 0; };
+	/**
+	 * @brief Store the taxa of each tree
+	 * @param taxa taxa[i] is the taxa in tree i, as label numbers 1,...,ntax with no repeats
+	 * @param num_taxa the number of taxa
+	 */
+	void SetTaxa (const std::vector< std::vector<int> > &taxa, int num_taxa);
+	/**
+	 * @brief Build the bitsets (and the matrix), unless this has already been done
+	 */
+	void Build ();
+	/**
+	 * @param id1 the id of a taxon (its label number minus one)
+	 * @param id2 the id of another taxon
+	 * @return the number of trees that contain both taxa
+	 */
+	int GetFreq (int id1, int id2) const;
+
+protected:
+	std::vector< std::vector<int> >	tree_taxa;
+	int								ntax;
+	std::once_flag					built;
+
+	// The bitset of the trees containing taxon id is
+	// trees[id * words],...,trees[id * words + words - 1]
+	size_t							words;
+	std::vector<unsigned long long>	trees;
+	// Only words first[id],...,last[id]-1 of the bitset of id can be non-zero
+	std::vector<size_t>				first;
+	std::vector<size_t>				last;
+	// If not empty, matrix[id1 * ntax + id2] is freq_co(id1,id2)
+	std::vector<int>				matrix;
+
+	void BuildBitsets ();
+	int CountShared (int id1, int id2) const;
+};
+
+#endif
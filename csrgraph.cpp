@@ -0,0 +1,198 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "csrgraph.h"
+
+//------------------------------------------------------------------------------
+void CSRGraph::Build (const graph &G, edge_map<int> &w)
+{
+	vertex_node.clear();
+	vertex_index.init (G, 0);
+	edge_arc.init (G, NO_ARC);
+
+	node x;
+	forall_nodes (x, G)
+	{
+		vertex_index[x] = (csr_index)vertex_node.size();
+		vertex_node.push_back (x);
+	}
+	csr_index n = (csr_index)vertex_node.size();
+
+	// Count arcs leaving each vertex (self loops are ignored)
+	offset.assign (n + 1, 0);
+	edge e;
+	forall_edges (e, G)
+	{
+		csr_index u = vertex_index[e.source()];
+		csr_index v = vertex_index[e.target()];
+		if (u != v)
+		{
+			offset[u + 1]++;
+			offset[v + 1]++;
+		}
+	}
+	for (csr_index i = 0; i < n; i++)
+		offset[i + 1] += offset[i];
+
+	// Fill arcs. The two arcs made from an edge are twins, and we note the
+	// arc for each edge
+	std::vector<csr_index> pos (offset.begin(), offset.end() - 1);
+	arcs.resize (offset[n]);
+	std::vector<csr_index> old_twin (offset[n]);
+	forall_edges (e, G)
+	{
+		csr_index u = vertex_index[e.source()];
+		csr_index v = vertex_index[e.target()];
+		if (u != v)
+		{
+			edge_arc[e] = pos[u];
+			old_twin[pos[u]] = pos[v];
+			old_twin[pos[v]] = pos[u];
+			arcs[pos[u]].target = v;
+			arcs[pos[u]++].weight = w[e];
+			arcs[pos[v]].target = u;
+			arcs[pos[v]++].weight = w[e];
+		}
+	}
+
+	std::vector<csr_index> moved;
+	MergeParallelArcs (old_twin, moved);
+
+	forall_edges (e, G)
+	{
+		if (edge_arc[e] != NO_ARC)
+			edge_arc[e] = moved[edge_arc[e]];
+	}
+}
+
+//------------------------------------------------------------------------------
+// The arcs of each vertex are in place, and old_twin gives the twin of each
+// arc. Merge parallel arcs, set twin, and return in moved[a] the arc that arc
+// a became.
+void CSRGraph::MergeParallelArcs (const std::vector<csr_index> &old_twin, std::vector<csr_index> &moved)
+{
+	// Merge parallel arcs in place. last[v] records where the arc to v from the
+	// current vertex was put, so each vertex is compacted in a single pass.
+	// moved[a] is where arc a ended up, and from[k] the arc that was kept as k.
+	csr_index n = (csr_index)offset.size() - 1;
+	std::vector<csr_index> last (n, NO_ARC);
+	moved.resize (arcs.size());
+	std::vector<csr_index> from (arcs.size());
+	csr_index k = 0;
+	csr_index start = 0;
+	for (csr_index u = 0; u < n; u++)
+	{
+		csr_index end = offset[u + 1];
+		offset[u] = k;
+		for (csr_index a = start; a < end; a++)
+		{
+			csr_index v = arcs[a].target;
+			if (last[v] != NO_ARC && last[v] >= offset[u])
+			{
+				arcs[last[v]].weight += arcs[a].weight;
+				moved[a] = last[v];
+			}
+			else
+			{
+				last[v] = k;
+				moved[a] = k;
+				from[k] = a;
+				arcs[k++] = arcs[a];
+			}
+		}
+		start = end;
+	}
+	offset[n] = k;
+	arcs.resize (k);
+
+	// Parallel edges between u and v are merged on both sides, so the twin
+	// of a kept arc is wherever the twin of the original arc went
+	twin.resize (k);
+	for (csr_index a = 0; a < k; a++)
+		twin[a] = moved[old_twin[from[a]]];
+}
+
+//------------------------------------------------------------------------------
+void CSRGraph::Contract (const CSRGraph &G, const std::vector<csr_index> &group, csr_index m,
+	std::vector<csr_index> &arc_map)
+{
+	csr_index n = G.GetNumVertices();
+
+	// Each new vertex stands for the first vertex of G in its group
+	vertex_node.assign (m, node());
+	std::vector<char> seen (m, 0);
+	for (csr_index v = 0; v < n; v++)
+	{
+		if (!seen[group[v]])
+		{
+			seen[group[v]] = 1;
+			vertex_node[group[v]] = G.GetNode (v);
+		}
+	}
+	
+	// Count arcs leaving each new vertex (arcs inside a group are dropped)
+	offset.assign (m + 1, 0);
+	for (csr_index u = 0; u < n; u++)
+	{
+		for (csr_index a = G.offset[u]; a < G.offset[u + 1]; a++)
+		{
+			if (group[u] != group[G.arcs[a].target])
+				offset[group[u] + 1]++;
+		}
+	}
+	for (csr_index i = 0; i < m; i++)
+		offset[i + 1] += offset[i];
+
+	// Fill arcs
+	std::vector<csr_index> pos (offset.begin(), offset.end() - 1);
+	arcs.resize (offset[m]);
+	arc_map.assign (G.GetNumArcs(), NO_ARC);
+	for (csr_index u = 0; u < n; u++)
+	{
+		for (csr_index a = G.offset[u]; a < G.offset[u + 1]; a++)
+		{
+			csr_index gu = group[u];
+			csr_index gv = group[G.arcs[a].target];
+			if (gu != gv)
+			{
+				arc_map[a] = pos[gu];
+				arcs[pos[gu]].target = gv;
+				arcs[pos[gu]++].weight = G.arcs[a].weight;
+			}
+		}
+	}
+	std::vector<csr_index> old_twin (arcs.size());
+	for (csr_index a = 0; a < G.GetNumArcs(); a++)
+	{
+		if (arc_map[a] != NO_ARC)
+			old_twin[arc_map[a]] = arc_map[G.twin[a]];
+	}
+
+	std::vector<csr_index> moved;
+	MergeParallelArcs (old_twin, moved);
+	for (csr_index a = 0; a < G.GetNumArcs(); a++)
+	{
+		if (arc_map[a] != NO_ARC)
+			arc_map[a] = moved[arc_map[a]];
+	}
+}
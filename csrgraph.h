@@ -0,0 +1,156 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file csrgraph.h
+ *
+ * Compact (compressed sparse row) copy of a weighted GTL graph
+ *
+ */
+
+#ifndef CSRGRAPHH
+#define CSRGRAPHH
+
+#include <vector>
+
+#include <GTL/graph.h>
+#include <GTL/node_map.h>
+#include <GTL/edge_map.h>
+
+/**
+ * @typedef csr_index
+ * Vertex and arc numbers in a CSRGraph. 32 bits is plenty for the graphs
+ * we build from a profile of trees, and keeps the arrays compact.
+ */
+typedef unsigned int csr_index;
+
+/**
+ * @def NO_ARC
+ * Returned by CSRGraph::GetArc for an edge that has no arc (a self loop).
+ */
+#define NO_ARC ((csr_index)-1)
+
+/**
+ * @struct CSRArc
+ * An arc in a CSRGraph. The target vertex and the weight are packed
+ * together so that a scan of a vertex's neighbours touches a single array.
+ */
+struct CSRArc
+{
+	csr_index	target;
+	int			weight;
+};
+
+/**
+ * @class CSRGraph
+ * A read-only copy of the visible part of a weighted, undirected GTL graph
+ * held as flat arrays. Vertices are numbered 0..n-1 in the order in which GTL
+ * lists the nodes. Each undirected edge becomes a pair of arcs, self loops
+ * are dropped, and parallel edges are merged into a single arc whose weight
+ * is the sum of their weights. The arcs of vertex v are
+ * arcs[offset[v]] ... arcs[offset[v+1]-1], and twin[a] is the arc in the
+ * opposite direction to arc a.
+ *
+ */
+class CSRGraph
+{
+public:
+	CSRGraph () {};
+
+	/**
+	 * @fn void Build (const graph &G, edge_map<int> &w)
+	 * Build the CSR copy of G using the weights w.
+	 * @param G the graph (unmodified)
+	 * @param w the edge weights
+	 */
+	void Build (const graph &G, edge_map<int> &w);
+
+	/**
+	 * @fn void Contract (const CSRGraph &G, const std::vector<csr_index> &group, csr_index m, std::vector<csr_index> &arc_map)
+	 * Build the graph obtained from G by merging each group of vertices into
+	 * a single vertex. Arcs inside a group are dropped, and parallel arcs are
+	 * merged. Vertex i of the new graph stands for (GetNode returns) the
+	 * first vertex of G in group i. GetIndex and GetArc are not defined for
+	 * the new graph.
+	 * @param G the graph (unmodified)
+	 * @param group group[v] is the group (0,...,m-1) that vertex v of G belongs to
+	 * @param m the number of groups
+	 * @param arc_map on return arc_map[a] is the arc of the new graph that arc a
+	 * of G became, or NO_ARC if a joins two vertices in the same group
+	 */
+	void Contract (const CSRGraph &G, const std::vector<csr_index> &group, csr_index m,
+		std::vector<csr_index> &arc_map);
+
+	/**
+	 * @fn csr_index GetNumVertices () const
+	 * @return the number of vertices
+	 */
+	csr_index GetNumVertices () const { return (csr_index)vertex_node.size(); };
+	/**
+	 * @fn csr_index GetNumArcs () const
+	 * @return the number of arcs (twice the number of merged edges)
+	 */
+	csr_index GetNumArcs () const { return (csr_index)arcs.size(); };
+	/**
+	 * @fn csr_index GetIndex (node n) const
+	 * @return the vertex number of node n
+	 */
+	csr_index GetIndex (node n) const { return vertex_index[n]; };
+	/**
+	 * @fn node GetNode (csr_index v) const
+	 * @return the GTL node corresponding to vertex v
+	 */
+	node GetNode (csr_index v) const { return vertex_node[v]; };
+	/**
+	 * @fn csr_index GetArc (edge e) const
+	 * @return the arc from the source of e to its target that e was merged
+	 * into, or NO_ARC if e is a self loop
+	 */
+	csr_index GetArc (edge e) const { return edge_arc[e]; };
+
+	/**
+	 * @var offset
+	 * offset[v] is the position of the first arc of vertex v in arcs,
+	 * offset[n] is the total number of arcs.
+	 */
+	std::vector<csr_index> 	offset;
+	/**
+	 * @var arcs
+	 * Arcs grouped by source vertex.
+	 */
+	std::vector<CSRArc> 	arcs;
+	/**
+	 * @var twin
+	 * twin[a] is the arc going the other way to arc a.
+	 */
+	std::vector<csr_index> 	twin;
+
+protected:
+	void MergeParallelArcs (const std::vector<csr_index> &old_twin, std::vector<csr_index> &moved);
+
+	std::vector<node>		vertex_node;
+	node_map<csr_index>		vertex_index;
+	edge_map<csr_index>		edge_arc;
+};
+
+#endif
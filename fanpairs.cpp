@@ -0,0 +1,139 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "fanpairs.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+void FanPairs::Build (const std::vector< std::vector<const ClusterSet *> > &fans)
+{
+	// Which taxa are present, and how many pairs the fans split
+	int max_element = 0;
+	double num_pairs = 0.0;
+	for (size_t i = 0; i < fans.size(); i++)
+	{
+		double total = 0.0;
+		double within = 0.0;
+		for (size_t c = 0; c < fans[i].size(); c++)
+		{
+			const ClusterSet *cluster = fans[i][c];
+			for (ClusterSet::iterator it = cluster->begin(); it != cluster->end(); ++it)
+				max_element = std::max (max_element, *it);
+			double k = cluster->size();
+			total += k;
+			within += k * k;
+		}
+		num_pairs += (total * total - within) / 2.0;
+	}
+	if (num_pairs == 0.0)
+		return;
+
+	row.assign (max_element + 1, -1);
+	for (size_t i = 0; i < fans.size(); i++)
+	{
+		for (size_t c = 0; c < fans[i].size(); c++)
+		{
+			for (ClusterSet::iterator it = fans[i][c]->begin(); it != fans[i][c]->end(); ++it)
+				row[*it] = 0;
+		}
+	}
+	n = 0;
+	for (int k = 0; k <= max_element; k++)
+	{
+		if (row[k] == 0)
+			row[k] = (int)n++;
+	}
+	double matrix_size = (double)n * (double)(n - 1) / 2.0;
+
+	if ((n > FAN_DENSE_LIMIT) || (matrix_size > 32.0 * num_pairs))
+	{
+		row.clear ();
+		counts.reserve ((size_t)num_pairs);
+		for (size_t i = 0; i < fans.size(); i++)
+		{
+			const std::vector<const ClusterSet *> &fan = fans[i];
+			for (size_t c1 = 0; c1 < fan.size(); c1++)
+			{
+				for (size_t c2 = c1 + 1; c2 < fan.size(); c2++)
+				{
+					for (ClusterSet::iterator it1 = fan[c1]->begin(); it1 != fan[c1]->end(); ++it1)
+					{
+						for (ClusterSet::iterator it2 = fan[c2]->begin(); it2 != fan[c2]->end(); ++it2)
+						{
+							// A taxon that is in the tree twice is not paired with itself
+							if (*it1 != *it2)
+								counts[Key ((*it1) - 1, (*it2) - 1)]++;
+						}
+					}
+				}
+			}
+		}
+		return;
+	}
+
+	// Each tree's taxa as sorted rows, with the child of the root each is below
+	matrix.assign ((size_t)matrix_size, 0);
+	std::vector< std::pair<int, int> > taxa;
+	for (size_t i = 0; i < fans.size(); i++)
+	{
+		taxa.clear ();
+		for (size_t c = 0; c < fans[i].size(); c++)
+		{
+			for (ClusterSet::iterator it = fans[i][c]->begin(); it != fans[i][c]->end(); ++it)
+				taxa.push_back (std::pair<int, int> (row[*it], (int)c));
+		}
+		std::sort (taxa.begin(), taxa.end());
+		for (size_t a = 0; a < taxa.size(); a++)
+		{
+			int *counts_row = &matrix[0] + Base (taxa[a].first);
+			for (size_t b = a + 1; b < taxa.size(); b++)
+			{
+				// A taxon that is in the tree twice is not paired with itself
+				if ((taxa[a].second != taxa[b].second) && (taxa[a].first != taxa[b].first))
+					counts_row[taxa[b].first]++;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+int FanPairs::GetFreq (int id1, int id2) const
+{
+	if (!matrix.empty())
+	{
+		if ((id1 + 1 >= (int)row.size()) || (id2 + 1 >= (int)row.size()) || (id1 == id2))
+			return 0;
+		int r1 = row[id1 + 1];
+		int r2 = row[id2 + 1];
+		if ((r1 == -1) || (r2 == -1))
+			return 0;
+		if (r1 > r2)
+			std::swap (r1, r2);
+		return matrix[Base (r1) + r2];
+	}
+	std::unordered_map<unsigned long long, int>::const_iterator it = counts.find (Key (id1, id2));
+	if (it == counts.end())
+		return 0;
+	return it->second;
+}
@@ -0,0 +1,91 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file fanpairs.h
+ *
+ * The number of trees in which pairs of taxa are split by a basal polytomy
+ *
+ */
+
+#ifndef FANPAIRSH
+#define FANPAIRSH
+
+#include <unordered_map>
+#include <vector>
+
+#include "clusterset.h"
+
+/**
+ * @def FAN_DENSE_LIMIT
+ * The largest number of taxa for which FanPairs will count the pairs in a
+ * dense matrix.
+ */
+#define FAN_DENSE_LIMIT 8192
+
+/**
+ * @class FanPairs
+ * Answers freq_fan(a,b), the number of trees whose root has more than two
+ * children and in which taxa a and b are below different children of the
+ * root. This is the frequency of the edge (a,b) in the graph of fans that
+ * CollapseGraph used to build with STGraph::AddEdge.
+ *
+ * If the pairs cover enough of the possible pairs of taxa they are counted in
+ * a triangular matrix with one row per taxon, otherwise (or if there are more
+ * than FAN_DENSE_LIMIT taxa) in a hash table keyed by the pair of taxon ids.
+ */
+class FanPairs
+{
+public:
+	FanPairs () { n = 0; };
+	/**
+	 * @brief Count the pairs of taxa split by each fan
+	 * @param fans fans[i] is the clusters of the children of the root of the
+	 * i-th tree with a basal polytomy. The elements are leaf label numbers.
+	 */
+	void Build (const std::vector< std::vector<const ClusterSet *> > &fans);
+	/**
+	 * @param id1 the id of a taxon (its label number minus one)
+	 * @param id2 the id of another taxon
+	 * @return the number of fans that split the two taxa
+	 */
+	int GetFreq (int id1, int id2) const;
+
+protected:
+	long long								n;
+	// Row of the matrix for the taxon with label number k, or -1
+	std::vector<int>						row;
+	// Count for pair of rows (i,j), i < j, is matrix[Base (i) + j]
+	std::vector<int>						matrix;
+	std::unordered_map<unsigned long long, int>	counts;
+
+	long long Base (long long i) const { return i * (2 * n - i - 1) / 2 - i - 1; };
+	unsigned long long Key (int id1, int id2) const
+	{
+		if (id1 > id2)
+			std::swap (id1, id2);
+		return ((unsigned long long)id1 << 32) | (unsigned int)id2;
+	};
+};
+
+#endif
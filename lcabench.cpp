@@ -0,0 +1,150 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+ 
+
+// $Id$
+
+/**
+ * @file lcabench.cpp
+ *
+ * Compare the speed of SimpleLCAQuery and EulerLCAQuery
+ *
+ */
+
+#include "TreeLib.h"
+#include "lcaquery.h"
+#include "nodeiterator.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Write a random binary tree with leaves first,...,first+n-1. Each split of
+// the leaves is uniform, unless caterpillar is true in which case one leaf
+// is split off at a time.
+void RandomTree (ostream &s, int first, int n, bool caterpillar)
+{
+	if (n == 1)
+	{
+		s << "t" << first;
+		return;
+	}
+	int k = caterpillar ? 1 : 1 + rand() % (n - 1);
+	s << "(";
+	RandomTree (s, first, k, caterpillar);
+	s << ",";
+	RandomTree (s, first + k, n - k, caterpillar);
+	s << ")";
+}
+
+//------------------------------------------------------------------------------
+// Time the queries, returning the answers in result
+double TimeQueries (LCAQuery &lca, const vector< pair<NodePtr, NodePtr> > &queries,
+	vector<NodePtr> &result, bool batch)
+{
+	clock_t t0 = clock();
+	if (batch)
+		lca.LCA (queries, result);
+	else
+	{
+		result.resize (queries.size());
+		for (size_t k = 0; k < queries.size(); k++)
+			result[k] = lca.LCA (queries[k].first, queries[k].second);
+	}
+	return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: lcabench leaves [queries [c]]" << endl;
+		cerr << "  c: use a caterpillar rather than a random tree" << endl;
+		exit (1);
+	}
+	int n = atoi (argv[1]);
+	int num_queries = (argc > 2) ? atoi (argv[2]) : 1000000;
+	bool caterpillar = (argc > 3) && (argv[3][0] == 'c');
+	if (n < 2)
+	{
+		cerr << "Need at least two leaves" << endl;
+		exit (1);
+	}
+	srand (1);
+
+	ostringstream s;
+	RandomTree (s, 1, n, caterpillar);
+	s << ";";
+	Tree t;
+	if (t.Parse (s.str().c_str()) != 0)
+	{
+		cerr << "Failed to parse tree" << endl;
+		exit (1);
+	}
+
+	vector<NodePtr> leaves;
+	NodeIterator <Node> it (t.GetRoot());
+	NodePtr q = it.begin();
+	while (q)
+	{
+		if (q->IsLeaf())
+			leaves.push_back (q);
+		q = it.next();
+	}
+	vector< pair<NodePtr, NodePtr> > queries (num_queries);
+	for (int k = 0; k < num_queries; k++)
+	{
+		queries[k].first = leaves[rand() % leaves.size()];
+		queries[k].second = leaves[rand() % leaves.size()];
+	}
+
+	cout << n << " leaves, " << num_queries << " queries"
+		<< (caterpillar ? " (caterpillar)" : "") << endl;
+
+	clock_t t0 = clock();
+	SimpleLCAQuery simple (&t);
+	double simple_init = (double)(clock() - t0) / CLOCKS_PER_SEC;
+	t0 = clock();
+	EulerLCAQuery euler (&t);
+	double euler_init = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+	vector<NodePtr> r1, r2, r3;
+	double simple_time = TimeQueries (simple, queries, r1, false);
+	double euler_time = TimeQueries (euler, queries, r2, false);
+	double batch_time = TimeQueries (euler, queries, r3, true);
+
+	cout << "SimpleLCAQuery: " << simple_init << "s to build, " << simple_time << "s to query" << endl;
+	cout << "EulerLCAQuery:  " << euler_init << "s to build, " << euler_time << "s to query, "
+		<< batch_time << "s as a batch" << endl;
+
+	if ((r1 != r2) || (r1 != r3))
+	{
+		cerr << "The LCAs differ" << endl;
+		exit (1);
+	}
+	return 0;
+}
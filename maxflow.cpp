@@ -0,0 +1,156 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "maxflow.h"
+
+#include <climits>
+
+#define NO_VERTEX ((csr_index)-1)
+
+//------------------------------------------------------------------------------
+DinicFlow::DinicFlow (const CSRGraph &G) : g(G)
+{
+	n = g.GetNumVertices();
+	source = sink = NO_VERTEX;
+	cap.resize (g.GetNumArcs());
+	level.resize (n);
+	current.resize (n);
+	queue.resize (n);
+	path.reserve (n);
+}
+
+//------------------------------------------------------------------------------
+// Breadth first search from the source over arcs with residual capacity.
+// Returns true if the sink can be reached.
+bool DinicFlow::BuildLevels ()
+{
+	level.assign (n, -1);
+	level[source] = 0;
+	csr_index head = 0;
+	csr_index tail = 0;
+	queue[tail++] = source;
+	while (head < tail)
+	{
+		csr_index v = queue[head++];
+		// Vertices further away than the sink can't be on a shortest path
+		if (level[sink] != -1 && level[v] >= level[sink])
+			break;
+		for (csr_index a = g.offset[v]; a < g.offset[v + 1]; a++)
+		{
+			csr_index w = g.arcs[a].target;
+			if (cap[a] > 0 && level[w] == -1)
+			{
+				level[w] = level[v] + 1;
+				queue[tail++] = w;
+			}
+		}
+	}
+	return (level[sink] != -1);
+}
+
+//------------------------------------------------------------------------------
+// Find a blocking flow in the level graph. This is a depth first search done
+// with an explicit path so that long paths can't overflow the stack.
+int DinicFlow::Augment ()
+{
+	int total = 0;
+	for (csr_index v = 0; v < n; v++)
+		current[v] = g.offset[v];
+	path.clear();
+
+	csr_index v = source;
+	for (;;)
+	{
+		if (v == sink)
+		{
+			// Push the bottleneck capacity along the path
+			int b = INT_MAX;
+			size_t first_saturated = 0;
+			for (size_t i = 0; i < path.size(); i++)
+			{
+				if (cap[path[i]] < b)
+				{
+					b = cap[path[i]];
+					first_saturated = i;
+				}
+			}
+			for (size_t i = 0; i < path.size(); i++)
+			{
+				cap[path[i]] -= b;
+				cap[g.twin[path[i]]] += b;
+			}
+			total += b;
+
+			// Carry on from the tail of the first arc we saturated
+			path.resize (first_saturated);
+			v = path.empty() ? source : g.arcs[path.back()].target;
+			continue;
+		}
+
+		// Advance along the current arc of v if we can
+		csr_index end = g.offset[v + 1];
+		csr_index a = current[v];
+		while ((a < end) && ((cap[a] <= 0) || (level[g.arcs[a].target] != level[v] + 1)))
+			a++;
+		current[v] = a;
+		if (a < end)
+		{
+			path.push_back (a);
+			v = g.arcs[a].target;
+		}
+		else
+		{
+			// Dead end, so remove v from the level graph and retreat
+			level[v] = -1;
+			if (path.empty())
+				break;
+			path.pop_back();
+			v = path.empty() ? source : g.arcs[path.back()].target;
+			current[v]++;
+		}
+	}
+	return total;
+}
+
+//------------------------------------------------------------------------------
+int DinicFlow::Run (csr_index s, csr_index t)
+{
+	source = s;
+	sink = t;
+	for (csr_index a = 0; a < g.GetNumArcs(); a++)
+		cap[a] = g.arcs[a].weight;
+
+	int flow = 0;
+	if (s != t)
+	{
+		while (BuildLevels ())
+			flow += Augment ();
+	}
+	return flow;
+}
+
+//------------------------------------------------------------------------------
+int DinicFlow::ResidualComponents (std::vector<int> &compnum)
+{
+	return scc.Run (g, cap, compnum);
+}
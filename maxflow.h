@@ -0,0 +1,102 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file maxflow.h
+ *
+ * Integer maximum flow on a CSRGraph
+ *
+ */
+
+#ifndef MAXFLOWH
+#define MAXFLOWH
+
+#include <vector>
+
+#include "csrgraph.h"
+#include "strong_components.h"
+
+/**
+ * @class DinicFlow
+ * Dinic's maximum flow algorithm for an undirected graph held as a CSRGraph.
+ * Each pair of twin arcs carries the flow for one edge. An arc starts with a
+ * residual capacity equal to the weight of the edge. Pushing f units along
+ * an arc takes f from its residual capacity and adds f to that of its twin,
+ * so no extra arcs are needed. The graph itself is never modified, and the
+ * same object can be used for any number of (s,t) pairs.
+ *
+ */
+class DinicFlow
+{
+public:
+	DinicFlow (const CSRGraph &G);
+
+	/**
+	 * @fn int Run (csr_index s, csr_index t)
+	 * Compute a maximum flow from s to t.
+	 * @param s the source
+	 * @param t the sink
+	 * @return the value of the flow
+	 */
+	int Run (csr_index s, csr_index t);
+
+	/**
+	 * @fn bool IsResidual (csr_index a) const
+	 * @return true if arc a is in the residual graph of the last flow computed,
+	 * i.e. it has some capacity left
+	 */
+	bool IsResidual (csr_index a) const { return cap[a] > 0; };
+
+	/**
+	 * @fn int ResidualComponents (std::vector<int> &compnum)
+	 * Find the strongly connected components of the residual graph of the last
+	 * flow computed.
+	 * @param compnum on return compnum[v] is the number (0,...,m-1) of
+	 * the component containing vertex v
+	 * @return m, the number of components
+	 */
+	int ResidualComponents (std::vector<int> &compnum);
+
+protected:
+	bool BuildLevels ();
+	int Augment ();
+
+	const CSRGraph			&g;
+	csr_index				n;
+	csr_index				source;
+	csr_index				sink;
+
+	// residual capacity of each arc
+	std::vector<int>		cap;
+
+	// level graph, the current arc of each vertex, and the augmenting path
+	std::vector<int>		level;
+	std::vector<csr_index>	current;
+	std::vector<csr_index>	queue;
+	std::vector<csr_index>	path;
+
+	// strong components of the residual graph
+	StrongComponents		scc;
+};
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "mincut_cactus.h"
+#include "maxflow.h"
+
+#include <algorithm>
+
+#define NO_VERTEX ((csr_index)-1)
+
+//------------------------------------------------------------------------------
+static csr_index Find (std::vector<csr_index> &parent, csr_index v)
+{
+	csr_index r = v;
+	while (parent[r] != r)
+		r = parent[r];
+	while (parent[v] != r)
+	{
+		csr_index next = parent[v];
+		parent[v] = r;
+		v = next;
+	}
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Compute a maximum adjacency ordering of H, merging (in parent) the ends of
+// any edge (x,y) that brings the attachment of y to at least k. Returns the
+// number of merges.
+static int MAOrderingMerge (const CSRGraph &H, int k, std::vector<csr_index> &parent)
+{
+	csr_index n = H.GetNumVertices();
+	std::vector<int> key (n, 0);
+	std::vector<char> in_A (n, 0);
+	std::vector< std::pair<int, csr_index> > pq;
+	pq.reserve (H.GetNumArcs() + n);
+	int merges = 0;
+
+	csr_index next_start = 0;
+	for (csr_index added = 0; added < n; added++)
+	{
+		// Most tightly connected vertex not in A. If the queue is empty the
+		// graph is disconnected, so start again from the first vertex not in A.
+		csr_index x = NO_VERTEX;
+		while (!pq.empty())
+		{
+			std::pair<int, csr_index> top = pq.front();
+			std::pop_heap (pq.begin(), pq.end());
+			pq.pop_back();
+			if (!in_A[top.second] && (top.first == key[top.second]))
+			{
+				x = top.second;
+				break;
+			}
+		}
+		if (x == NO_VERTEX)
+		{
+			while (in_A[next_start])
+				next_start++;
+			x = next_start;
+		}
+
+		in_A[x] = 1;
+		for (csr_index a = H.offset[x]; a < H.offset[x + 1]; a++)
+		{
+			csr_index y = H.arcs[a].target;
+			if (!in_A[y])
+			{
+				key[y] += H.arcs[a].weight;
+				if (key[y] >= k)
+				{
+					csr_index rx = Find (parent, x);
+					csr_index ry = Find (parent, y);
+					if (rx != ry)
+					{
+						parent[ry] = rx;
+						merges++;
+					}
+				}
+				pq.push_back (std::pair<int, csr_index> (key[y], y));
+				std::push_heap (pq.begin(), pq.end());
+			}
+		}
+	}
+	return merges;
+}
+
+//------------------------------------------------------------------------------
+void CactusMinCutArcs (const CSRGraph &G, int lambda, std::vector<char> &in_a_min_cut_set)
+{
+	csr_index n = G.GetNumVertices();
+	in_a_min_cut_set.assign (G.GetNumArcs(), 0);
+	if (n < 2)
+		return;
+
+	// group[v] is the vertex of the merged graph H that v belongs to, and
+	// arc_map takes arcs of G to arcs of H
+	std::vector<csr_index> group (n);
+	std::vector<csr_index> arc_map (G.GetNumArcs());
+	for (csr_index v = 0; v < n; v++)
+		group[v] = v;
+	for (csr_index a = 0; a < G.GetNumArcs(); a++)
+		arc_map[a] = a;
+	CSRGraph H = G;
+
+	// 1. Merge vertices using maximum adjacency orderings
+	for (;;)
+	{
+		csr_index m = H.GetNumVertices();
+		std::vector<csr_index> parent (m);
+		for (csr_index i = 0; i < m; i++)
+			parent[i] = i;
+		if (MAOrderingMerge (H, lambda + 1, parent) == 0)
+			break;
+
+		// Number the merged vertices, and contract H
+		std::vector<csr_index> h_group (m, NO_VERTEX);
+		csr_index count = 0;
+		for (csr_index i = 0; i < m; i++)
+		{
+			csr_index r = Find (parent, i);
+			if (h_group[r] == NO_VERTEX)
+				h_group[r] = count++;
+			h_group[i] = h_group[r];
+		}
+		std::vector<csr_index> h_arc_map;
+		CSRGraph next;
+		next.Contract (H, h_group, count, h_arc_map);
+
+		for (csr_index v = 0; v < n; v++)
+			group[v] = h_group[group[v]];
+		for (csr_index a = 0; a < G.GetNumArcs(); a++)
+		{
+			if (arc_map[a] != NO_ARC)
+				arc_map[a] = h_arc_map[arc_map[a]];
+		}
+		H = next;
+		if (count == 1)
+			break;
+	}
+
+	// 2. Classify the remaining edges of H using flows
+	csr_index m = H.GetNumVertices();
+	std::vector<char> cut (H.GetNumArcs(), 0);
+	std::vector<char> done (H.GetNumArcs(), 0);
+	std::vector<csr_index> same (m);
+	for (csr_index i = 0; i < m; i++)
+		same[i] = i;
+	std::vector<int> cp;
+	DinicFlow flow (H);
+
+	for (csr_index x = 0; x < m; x++)
+	{
+		for (csr_index a = H.offset[x]; a < H.offset[x + 1]; a++)
+		{
+			csr_index y = H.arcs[a].target;
+			if (done[a])
+				continue;
+			done[a] = done[H.twin[a]] = 1;
+
+			csr_index rx = Find (same, x);
+			csr_index ry = Find (same, y);
+			if (rx == ry)
+				continue;
+
+			if (flow.Run (x, y) > lambda)
+			{
+				// x and y are in the same node of the cactus
+				same[ry] = rx;
+			}
+			else
+			{
+				flow.ResidualComponents (cp);
+				for (csr_index u = 0; u < m; u++)
+				{
+					for (csr_index b = H.offset[u]; b < H.offset[u + 1]; b++)
+					{
+						if (cp[u] != cp[H.arcs[b].target])
+						{
+							cut[b] = 1;
+							done[b] = 1;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (csr_index a = 0; a < G.GetNumArcs(); a++)
+	{
+		if (arc_map[a] != NO_ARC)
+			in_a_min_cut_set[a] = cut[arc_map[a]];
+	}
+}
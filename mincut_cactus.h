@@ -0,0 +1,67 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file mincut_cactus.h
+ *
+ * Find all edges in a minimum cut from the nodes of the cactus of minimum cuts
+ *
+ */
+
+#ifndef MINCUT_CACTUSH
+#define MINCUT_CACTUSH
+
+#include <vector>
+
+#include "csrgraph.h"
+
+/**
+ * @fn void CactusMinCutArcs (const CSRGraph &G, int lambda, std::vector<char> &in_a_min_cut_set)
+ * @brief find all arcs of G that are in at least one minimum cut
+ *
+ * @param G the graph
+ * @param lambda the weight of a minimum cut of G
+ * @param in_a_min_cut_set on return in_a_min_cut_set[a] is 1 if arc a is in a minimum cut
+ *
+ * The minimum cuts of a graph can be represented by a cactus, and each vertex of the
+ * graph maps to a node of the cactus. Two vertices u and v map to the same node if and
+ * only if no minimum cut separates them, i.e. @f$\lambda(u,v) > \lambda@f$. An edge is in
+ * some minimum cut if and only if its ends map to different nodes. We find
+ * these classes of vertices without building the cycles of the cactus:
+ *   -# Compute a maximum adjacency ordering of G. By a result of Nagamochi and Ibaraki,
+ *      if scanning edge (x,y) brings the attachment of y to @f$\lambda+1@f$ or more, then
+ *      @f$\lambda(x,y) > \lambda@f$, so x and y can be merged. Repeat on the merged graph
+ *      until no more vertices are merged.
+ *   -# For each edge (x,y) of the merged graph whose ends have not been classified,
+ *      compute a maximum x-y flow. If the flow is more than @f$\lambda@f$ then x and y are in
+ *      the same class. Otherwise every edge whose ends lie in different strong components
+ *      of the residual graph is in a minimum x-y cut, and hence in a minimum cut
+ *      (Picard and Queyranne), so one flow classifies many edges.
+ *
+ * In the graphs we get from ST/Emax most vertices are merged by the first step, so
+ * the number of flows is much smaller than the number of (s,t) pairs found by
+ * mincut_st when many minimum cuts tie.
+ */
+void CactusMinCutArcs (const CSRGraph &G, int lambda, std::vector<char> &in_a_min_cut_set);
+
+#endif
@@ -9,10 +9,8 @@
 #include <list>
 #include <map>
 #include <set>
-
-#ifdef __GNUC__
+#include <vector>
 #include <algorithm>
-#endif
 
 #ifdef __BORLANDC__
 	#include <values.h>
@@ -22,160 +20,163 @@
 	#define MAXINT INT_MAX
 #endif
 
-#include "fheap.h"
+#include "csrgraph.h"
 
 
 bool bShowOriginal 	= false;	
-bool bShowCopy		= false;
 bool bShowEdges		= false;	
 bool bShowCut		= false;
 
 
-int mincut_st (const graph &G0, edge_map <int> &w0, list<node_pair> &st_list)
+//------------------------------------------------------------------------------
+// Stoer-Wagner on a CSRGraph. Merged vertices are tracked with a union-find
+// forest plus a linked list of the original vertices that make up each
+// super-vertex, so the arc array is never rewritten: the neighbours of a
+// super-vertex are the arcs of its members, with targets mapped to their
+// current super-vertex through the union-find forest. All work arrays are
+// allocated once and reused by every phase.
+class StoerWagner
 {
-	// If graph is not connected then minimum weight cut is zero, and we do not need to
-	// compute a minimum cut. 
-	if (!G0.is_connected())
-		return 0;
-
-
-	graph G;
-    G.make_undirected();
-
-	if (bShowOriginal)
-	{
-	    cout << "Original graph" << endl << G0 << endl;
-	 	   
-	}
-
+public:
+	StoerWagner (const CSRGraph &G);
+	int Run (list<node_pair> &st_list);
 
+protected:
+	csr_index Find (csr_index v);
+	void AddToA (csr_index x);
+	
+	const CSRGraph		&g;
+	csr_index 			n;
+	
+	// union-find parent, and list of members of each super-vertex
+	vector<csr_index>	parent;
+	vector<csr_index>	next_member;
+	vector<csr_index>	last_member;
 
-    // Make a local copy of the graph as MinimumCut modifies the original graph
+	// super-vertices still in the graph, in GTL node order
+	vector<csr_index>	active;
+	
+	// per phase work arrays
+	vector<int>			key;
+	vector<char>		in_A;
+	vector< pair<int, csr_index> > pq;
+};
 
-	// List of nodes in the original graph
-	node_map <node> partner (G0);
-	node_map <node> orig (G);
+#define NO_VERTEX ((csr_index)-1)
 
-	node x;
-	int counter = 0;
-	forall_nodes (x, G0)
+//------------------------------------------------------------------------------
+StoerWagner::StoerWagner (const CSRGraph &G) : g(G)
+{
+	n = g.GetNumVertices();
+	parent.resize (n);
+	next_member.assign (n, NO_VERTEX);
+	last_member.resize (n);
+	active.resize (n);
+	for (csr_index i = 0; i < n; i++)
 	{
-		partner[x] = G.new_node(); 
-		orig[partner[x]] = x; // so we can look up original node
-	}
-
-	// Create edges and associated weights
-	edge_map<int> w(G, 0);
-	edge e;
-	forall_edges (e, G0)
-	{
-		if (e.source() != e.target())
-		{
-			edge ec = G.new_edge (partner[e.source()], partner[e.target()]);
-			w[ec] = w0[e];
-		}
+		parent[i] = i;
+		last_member[i] = i;
+		active[i] = i;
 	}
+	key.resize (n);
+	in_A.resize (n);
+	pq.reserve (g.GetNumArcs() + n);
+}
 
-	// Display the graph
-	if (bShowCopy)
+//------------------------------------------------------------------------------
+csr_index StoerWagner::Find (csr_index v)
+{
+	csr_index r = v;
+	while (parent[r] != r)
+		r = parent[r];
+	while (parent[v] != r)
 	{
-		cout << "Copy of graph" << endl << G << endl;
-		G.save ("start.gml");
+		csr_index next = parent[v];
+		parent[v] = r;
+		v = next;
 	}
+	return r;
+}
 
-	// Display edge weights
-	if (bShowEdges)
+//------------------------------------------------------------------------------
+// Add super-vertex x to A and increase the key of its neighbours not in A
+void StoerWagner::AddToA (csr_index x)
+{
+	in_A[x] = 1;
+	for (csr_index m = x; m != NO_VERTEX; m = next_member[m])
 	{
-		cout << "Edge weights" << endl;
-		graph::edge_iterator it = G.edges_begin();
-		graph::edge_iterator end = G.edges_end();
-	
-		while (it != end)
+		const CSRArc *a = &g.arcs[0] + g.offset[m];
+		const CSRArc *end = &g.arcs[0] + g.offset[m + 1];
+		while (a != end)
 		{
-			cout << *it << " " << w[*it] << endl;
-			it++;
-		} 
+			csr_index v = Find (a->target);
+			if (!in_A[v])
+			{
+				key[v] += a->weight;
+				pq.push_back (pair<int, csr_index> (key[v], v));
+				push_heap (pq.begin(), pq.end());
+			}
+			a++;
+		}
 	}
+}
 
-	// Start of algorithm. $a$ is an arbitrary single node in $G$. The set $A$
-	// of nodes initially comprises $a$
-	graph::node_iterator na = G.nodes_begin();
-	node a = *na;
-	int n = G.number_of_nodes();
-	int cut_weight = MAXINT;
+//------------------------------------------------------------------------------
+int StoerWagner::Run (list<node_pair> &st_list)
+{
 	int best_value = MAXINT;
-	while (n >= 2 )
+	
+	// Start of algorithm. $a$ is an arbitrary single node in $G$ (we use the
+	// first one). $a$ is never merged into another node, so it remains the
+	// first active node throughout.
+	while (active.size() >= 2)
 	{
-		node t = a;
-		node s, v;
-		edge e;
-   		node::adj_edges_iterator it;
-		node::adj_edges_iterator end;
-		
-		fheap_t *pq = fh_alloc (n);
-		node_map<int> vertex_number (G, 0);
-		map <int, node, less<int> > nv;
-		int vertex_count = 0;
-			
-		// Nodes in $A$ are not in the queue
-		node_map<bool> in_PQ(G, false);
-		forall_nodes (v, G)
-		{
-			vertex_number[v] = vertex_count;
-			nv[vertex_count] = v;
-			vertex_count++;
-			if (v != a)
-			{
-				in_PQ[v] = true;
-				fh_insert (pq, vertex_number[v], 0);	
-			}
-		}
-		node_map<int> inf (G, 0); 
-		// Get weight of edges adjacent to $a$
-		it = a.adj_edges_begin();
-		end = a.adj_edges_end();
-		while (it != end)
-		{
-			v = a.opposite (*it);
-			inf[v] += w[*it];	
-			it++;
-		}
-		// Store weights in a queue
-		it = a.adj_edges_begin();
-		end = a.adj_edges_end();
-		while (it != end)
+		vector<csr_index>::iterator it;
+		for (it = active.begin(); it != active.end(); it++)
 		{
-			v = a.opposite (*it);
-			fh_decrease_key (pq, vertex_number[v], -inf[v]);  
-			it++;
+			key[*it] = 0;
+			in_A[*it] = 0;
 		}
+		pq.clear();
 
-		while (pq->n > 0)
+		csr_index s = NO_VERTEX;
+		csr_index t = active[0];
+		AddToA (t);
+		size_t added = 1;
+		while (added < active.size())
 		{
-			s = t;
-
-			// Get the node that is most tightly connected to $A$
-			t = nv[fh_delete_min (pq)];
-			cut_weight = inf[t];
-			in_PQ[t] = false;
-
-			// Increase the key of nodes adjacent to t and not in $A$ by adding the
-			// weights of edges connecting t with nodes not in $A$ 
-			it = t.adj_edges_begin();
-			end = t.adj_edges_end();
-			while (it != end)
+			// Get the node that is most tightly connected to $A$. Nodes not adjacent
+			// to $A$ have key 0 and are not in the queue, so if the queue runs dry we
+			// take the first such node.
+			csr_index v = NO_VERTEX;
+			while (!pq.empty())
+			{
+				pair<int, csr_index> top = pq.front();
+				pop_heap (pq.begin(), pq.end());
+				pq.pop_back();
+				if (!in_A[top.second] && (top.first == key[top.second]))
+				{
+					v = top.second;
+					break;
+				}
+			}
+			if (v == NO_VERTEX)
 			{
-				v = t.opposite (*it);
-				if (in_PQ[v])
+				for (it = active.begin(); it != active.end(); it++)
 				{
-					inf[v] += w[*it];
-					fh_decrease_key (pq, vertex_number[v], -inf[v]);  
+					if (!in_A[*it])
+					{
+						v = *it;
+						break;
+					}
 				}
-				it++;
-			}	
+			}
+			s = t;
+			t = v;
+			AddToA (t);
+			added++;
 		}
-		fh_free (pq);
-		
+		int cut_weight = key[t];
 		
 		if (bShowCut)
 			cout << "   cut-of-the-phase = " << cut_weight << endl;
@@ -188,72 +189,52 @@ int mincut_st (const graph &G0, edge_map <int> &w0, list<node_pair> &st_list)
 				st_list.erase (st_list.begin(), st_list.end());
 				best_value = cut_weight;
 			}
-			st_list.push_back (node_pair (orig[s], orig[t]));
+			st_list.push_back (node_pair (g.GetNode(s), g.GetNode(t)));
 		}
 
 		// Nodes s and t are the last two nodes to be added to A
 
 		if (bShowCut)
 		{
-			cout << "s=" << s << " t=" << t << endl;
-					 
+			cout << "s=" << g.GetNode(s) << " t=" << g.GetNode(t) << endl;
 		}
 
-		// Get list of edges adjacent to s
-		edge dummy;
-		node_map<edge> s_edge(G, dummy);
-		it = s.adj_edges_begin();
-		end = s.adj_edges_end();
-		while (it != end)
-		{
-			s_edge[s.opposite(*it)] = *it;
-			it++;
-		}
-
-		// Merge s and t
-   		it = t.adj_edges_begin();
-    	end = t.adj_edges_end();
-
-
-		// Iterate over edges adjacent to t. If a node v adjacent to
-		// t is also adjacent to s, then add w(it) to e(s,v)
-		// otherwise make a new edge e(s,v)
-		while (it != end)
-		{
-			v = t.opposite (*it);
-
-			if (s_edge[v] != dummy)
-			{
-				w[s_edge[v]] += w[*it];
-			}
-			else if (s != v)
-			{
-				edge ne = G.new_edge (s, v);
-				w[ne] = w[*it];
-			}				
-			it++;
-
-			
-		}
+		// Merge t into s
+		parent[t] = s;
+		next_member[last_member[s]] = t;
+		last_member[s] = last_member[t];
+		active.erase (find (active.begin(), active.end(), t));
+	}
+	return best_value;
+}
 
-		// Delete node t from graph
-		G.del_node(t);
+//------------------------------------------------------------------------------
+int mincut_st (const graph &G0, edge_map <int> &w0, list<node_pair> &st_list)
+{
+	// If graph is not connected then minimum weight cut is zero, and we do not need to
+	// compute a minimum cut. 
+	if (!G0.is_connected())
+		return 0;
 
-		
-		if (bShowCut)
-		{
-			char fname[256];
-			sprintf (fname, "step%d.gml", n);
-			G.save (fname);
-			 
-		}
+	if (bShowOriginal)
+	{
+	    cout << "Original graph" << endl << G0 << endl;
+	}
 
-		n--;
-		
-		
+	// Make a compact copy of the graph 
+	CSRGraph G;
+	G.Build (G0, w0);
 
+	// Display edge weights
+	if (bShowEdges)
+	{
+		cout << "Edge weights" << endl;
+		for (csr_index u = 0; u < G.GetNumVertices(); u++)
+			for (csr_index a = G.offset[u]; a < G.offset[u + 1]; a++)
+				if (u < G.arcs[a].target)
+					cout << u << " " << G.arcs[a].target << " " << G.arcs[a].weight << endl;
 	}
-		
-    return best_value;
 
+	StoerWagner sw (G);
+	return sw.Run (st_list);
 }
@@ -23,7 +23,8 @@ typedef pair<node, node> node_pair;
  * @fn mincut_st (const graph &G0, edge_map <int> &w0, list<node_pair> &st_list)
  * @brief Find mincut of a graph
  * Computes a global mincut for a graph, and stores a list of pairs of (s,t)
- * nodes that have this cut value.
+ * nodes that have this cut value. The Stoer-Wagner algorithm is run on a
+ * compact copy of the graph (see CSRGraph) rather than on a GTL graph.
  * @param G0 the input graph (unmodified by this function)
  * @param w0 the edges weights
  * @param st_list a list of (s,t) node pairs for which a (s,t) cut is a best cut
@@ -0,0 +1,257 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "mrpmatrix.h"
+#include "clusterset.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+/**
+ * @struct MRPBlock
+ * Trees first,...,last-1 and the text of their rows of the matrix
+ */
+struct MRPBlock
+{
+	size_t		first;
+	size_t		last;
+	std::string	text;
+};
+
+//------------------------------------------------------------------------------
+void GetMRPCharacters (const FlatTree &t, size_t words, std::vector<unsigned long long> &coded,
+	std::vector<unsigned long long> &ones)
+{
+	std::vector<unsigned long long> bits;
+	t.GetClusterBitsets (words, bits);
+	coded.assign (words, 0);
+	ones.clear ();
+	if (bits.empty())
+		return;
+	std::copy (bits.begin(), bits.begin() + words, coded.begin());
+
+	// Visit the nodes in preorder. A node is left in postorder once the
+	// next node in preorder is not one of its descendants.
+	int n = t.GetNumNodes();
+	std::vector<int> index (n, -1);
+	int internals = 0;
+	for (int v = 0; v < n; v++)
+	{
+		if (!t.IsLeaf (v))
+			index[v] = internals++;
+	}
+	ones.reserve (bits.size());
+	std::vector<int> open;
+	for (int v = 0; v <= n; v++)
+	{
+		while (!open.empty() && ((v == n) || (v >= open.back() + t.GetSize (open.back()))))
+		{
+			const unsigned long long *b = &bits[0] + index[open.back()] * words;
+			ones.insert (ones.end(), b, b + words);
+			open.pop_back();
+		}
+		if ((v < n) && !t.IsLeaf (v))
+			open.push_back (v);
+	}
+}
+
+//------------------------------------------------------------------------------
+static void FormatBlock (const std::vector<FlatTree> &T, int ntax, MRPBlock &block)
+{
+	size_t words = (size_t)ntax / 64 + 1;
+	std::vector<unsigned long long> coded;
+	std::vector<unsigned long long> ones;
+
+	// A line is the state of mrp_outgroup, the states of taxa 1,...,ntax,
+	// and the end of line, so the state of taxon j is at position j
+	std::string blank (ntax + 2, '?');
+	blank[0] = '0';
+	blank[ntax + 1] = '\n';
+	for (size_t i = block.first; i < block.last; i++)
+	{
+		block.text += "[";
+		block.text += T[i].GetName();
+		block.text += "]\n";
+		GetMRPCharacters (T[i], words, coded, ones);
+
+		// Taxa in the tree are 0 unless they are in the cluster
+		std::string line (blank);
+		for (size_t k = 0; k < words; k++)
+		{
+			for (unsigned long long b = coded[k]; b != 0; b &= b - 1)
+				line[64 * k + ClusterSet::LowestBit (b)] = '0';
+		}
+		for (size_t c = 0; c < ones.size(); c += words)
+		{
+			size_t start = block.text.size();
+			block.text += line;
+			char *s = &block.text[start];
+			for (size_t k = 0; k < words; k++)
+			{
+				for (unsigned long long b = ones[c + k]; b != 0; b &= b - 1)
+					s[64 * k + ClusterSet::LowestBit (b)] = '1';
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void WriteMRPMatrix (std::ostream &f, const std::vector<FlatTree> &T, int ntax, ThreadPool *pool)
+{
+	// Split the trees into blocks with about MRP_BLOCK_SIZE bytes of text
+	std::vector<MRPBlock> blocks;
+	size_t first = 0;
+	size_t bytes = 0;
+	for (size_t i = 0; i < T.size(); i++)
+	{
+		bytes += (size_t)(T[i].GetNumNodes() - T[i].GetNumLeaves()) * (ntax + 2);
+		if ((bytes >= MRP_BLOCK_SIZE) || (i == T.size() - 1))
+		{
+			MRPBlock b;
+			b.first = first;
+			b.last = i + 1;
+			blocks.push_back (b);
+			first = i + 1;
+			bytes = 0;
+		}
+	}
+
+	// Format a batch of blocks at a time, so that only the text of one batch
+	// is held in memory
+	size_t batch = (pool != NULL) ? 2 * pool->GetNumThreads() : 1;
+	for (size_t b = 0; b < blocks.size(); b += batch)
+	{
+		size_t e = std::min (b + batch, blocks.size());
+		if (pool != NULL)
+		{
+			TaskGroup group;
+			for (size_t k = b; k < e; k++)
+			{
+				MRPBlock *block = &blocks[k];
+				pool->Submit (group, [&T, ntax, block] { FormatBlock (T, ntax, *block); });
+			}
+			pool->Wait (group);
+		}
+		else
+			FormatBlock (T, ntax, blocks[b]);
+		for (size_t k = b; k < e; k++)
+		{
+			f.write (blocks[k].text.data(), blocks[k].text.size());
+			std::string().swap (blocks[k].text);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+bool WriteBinaryMRP (const char *filename, const std::vector<FlatTree> &T,
+	const std::vector<std::string> &labels)
+{
+	struct Header
+	{
+		char				signature[8];
+		unsigned int		version;
+		unsigned int		byte_order;
+		unsigned long long	ntax;
+		unsigned long long	num_trees;
+		unsigned long long	nchar;
+		unsigned long long	words;
+		unsigned long long	trees_offset;
+		unsigned long long	coded_offset;
+		unsigned long long	chars_offset;
+		unsigned long long	strings_offset;
+		unsigned long long	file_size;
+	};
+
+	size_t ntax = labels.size();
+	size_t words = ntax / 64 + 1;
+	size_t row_bytes = words * sizeof (unsigned long long);
+
+	std::vector<unsigned long long> records;
+	unsigned long long nchar = 0;
+	for (size_t i = 0; i < T.size(); i++)
+	{
+		unsigned long long n = T[i].GetNumNodes() - T[i].GetNumLeaves();
+		records.push_back (nchar);
+		records.push_back (n);
+		nchar += n;
+	}
+	std::vector<unsigned long long> string_offsets (1, 0);
+	for (size_t i = 0; i < labels.size(); i++)
+		string_offsets.push_back (string_offsets.back() + labels[i].size());
+	for (size_t i = 0; i < T.size(); i++)
+		string_offsets.push_back (string_offsets.back() + T[i].GetName().size());
+
+	Header h;
+	memset (&h, 0, sizeof (h));
+	memcpy (h.signature, "\x89STMRP\r\n", sizeof (h.signature));
+	h.version			= MRP_BINARY_VERSION;
+	h.byte_order		= 0x01020304;
+	h.ntax				= ntax;
+	h.num_trees			= T.size();
+	h.nchar				= nchar;
+	h.words				= words;
+	h.trees_offset		= sizeof (Header);
+	h.coded_offset		= h.trees_offset + records.size() * sizeof (unsigned long long);
+	h.chars_offset		= h.coded_offset + T.size() * row_bytes;
+	h.strings_offset	= h.chars_offset + nchar * row_bytes;
+	h.file_size			= h.strings_offset + string_offsets.size() * sizeof (unsigned long long)
+		+ string_offsets.back();
+
+	std::ofstream f (filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!f)
+		return false;
+	f.write ((const char *)&h, sizeof (h));
+	if (!records.empty())
+		f.write ((const char *)&records[0], records.size() * sizeof (unsigned long long));
+
+	// The taxa in each tree
+	std::vector<unsigned long long> coded;
+	for (size_t i = 0; i < T.size(); i++)
+	{
+		coded.assign (words, 0);
+		for (int v = 0; v < T[i].GetNumNodes(); v++)
+		{
+			if (T[i].IsLeaf (v))
+				coded[T[i].GetLabelNumber (v) / 64] |= 1ULL << (T[i].GetLabelNumber (v) % 64);
+		}
+		f.write ((const char *)&coded[0], row_bytes);
+	}
+
+	// The characters
+	std::vector<unsigned long long> ones;
+	for (size_t i = 0; i < T.size(); i++)
+	{
+		GetMRPCharacters (T[i], words, coded, ones);
+		if (!ones.empty())
+			f.write ((const char *)&ones[0], ones.size() * sizeof (unsigned long long));
+	}
+
+	f.write ((const char *)&string_offsets[0], string_offsets.size() * sizeof (unsigned long long));
+	for (size_t i = 0; i < labels.size(); i++)
+		f.write (labels[i].data(), labels[i].size());
+	for (size_t i = 0; i < T.size(); i++)
+		f.write (T[i].GetName().data(), T[i].GetName().size());
+	f.close ();
+	return !f.fail();
+}
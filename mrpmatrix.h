@@ -0,0 +1,114 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file mrpmatrix.h
+ *
+ * Matrix representation with parsimony (MRP) coding of a set of trees
+ *
+ */
+
+#ifndef MRPMATRIXH
+#define MRPMATRIXH
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "flattree.h"
+#include "threadpool.h"
+
+/**
+ * @def MRP_BLOCK_SIZE
+ * The number of bytes of the matrix that WriteMRPMatrix formats in one task
+ * before it is written.
+ */
+#define MRP_BLOCK_SIZE (4 * 1024 * 1024)
+
+/**
+ * @def MRP_BINARY_VERSION
+ * Version of the binary MRP matrix format written by WriteBinaryMRP.
+ */
+#define MRP_BINARY_VERSION 1
+
+/**
+ * @fn void GetMRPCharacters (const FlatTree &t, size_t words, std::vector<unsigned long long> &coded, std::vector<unsigned long long> &ones)
+ * @brief the MRP characters of a tree as bit-packed rows
+ *
+ * Each internal node of t is a binary character, in which a taxon has state 1 if
+ * it is in the cluster of the node, 0 if it is in the tree but not in the
+ * cluster, and is missing if it is not in the tree. In each bitset bit j is
+ * for the taxon with label number j.
+ * @param t the tree, whose leaf label numbers must be set
+ * @param words the number of 64 bit words in each bitset
+ * @param coded set to the cluster of the root, i.e. the taxa that are not missing
+ * @param ones set to the clusters of the internal nodes, one after the other, in
+ * the order NodeIterator visits them (postorder)
+ */
+void GetMRPCharacters (const FlatTree &t, size_t words, std::vector<unsigned long long> &coded,
+	std::vector<unsigned long long> &ones);
+
+/**
+ * @fn void WriteMRPMatrix (std::ostream &f, const std::vector<FlatTree> &T, int ntax, ThreadPool *pool)
+ * @brief write the rows of a transposed MRP matrix in NEXUS format
+ *
+ * For each tree writes its name as a comment, then one line for each of its
+ * characters, starting with the state (0) of mrp_outgroup, followed by the
+ * states of the taxa with label numbers 1,...,ntax ('?' if missing).
+ *
+ * Each line is filled in from the bitsets of GetMRPCharacters. The trees are
+ * split into blocks of about MRP_BLOCK_SIZE bytes of text, which are formatted
+ * into buffers by tasks in the pool (if it is not NULL), and written to f in order
+ * with one call per block.
+ */
+void WriteMRPMatrix (std::ostream &f, const std::vector<FlatTree> &T, int ntax, ThreadPool *pool);
+
+/**
+ * @fn bool WriteBinaryMRP (const char *filename, const std::vector<FlatTree> &T, const std::vector<std::string> &labels)
+ * @brief write an MRP matrix in a compact binary format
+ *
+ * The file holds the same characters as the NEXUS matrix, as bitsets of
+ * w = ntax / 64 + 1 64-bit words in which bit j is the taxon with label
+ * number j (bit 0 is not used). All numbers are unsigned and in the byte order
+ * of the machine that wrote the file. The file starts with a header of
+ * 16 bytes followed by 9 64-bit numbers:
+ * - signature "\x89STMRP\r\n", version (32 bits), 0x01020304 (32 bits)
+ * - ntax, the number of trees, nchar, w
+ * - the offsets of the tree records, the coded rows, the character rows and
+ *   the strings, and the size of the file
+ *
+ * For each tree a record holds the index of its first character and the
+ * number of characters (64 bits each). The coded rows give the taxa in each
+ * tree, one row per tree. The character rows give the taxa with state 1,
+ * one row per character, in the order of the NEXUS matrix. The strings are
+ * ntax + (number of trees) + 1 64-bit offsets followed by the characters:
+ * string i is the label of taxon i + 1, and string ntax + k the name of tree k.
+ * @param filename name of the file
+ * @param T the trees, whose leaf label numbers must be set
+ * @param labels the taxon labels, labels[i] being the label of taxon i + 1
+ * @return true if the file was written
+ */
+bool WriteBinaryMRP (const char *filename, const std::vector<FlatTree> &T,
+	const std::vector<std::string> &labels);
+
+#endif
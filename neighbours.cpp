@@ -0,0 +1,145 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "neighbours.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+void NeighbourSets::Build (const graph &G, edge_map<int> &colour, int excluded)
+{
+	vertex_index.init (G, 0);
+	int n = 0;
+	node x;
+	forall_nodes (x, G)
+	{
+		vertex_index[x] = n++;
+	}
+
+	// Count the neighbours of each vertex
+	edges.clear ();
+	offset.assign (n + 1, 0);
+	edge e;
+	forall_edges (e, G)
+	{
+		if (colour[e] != excluded)
+		{
+			offset[vertex_index[e.source()] + 1]++;
+			offset[vertex_index[e.target()] + 1]++;
+			edges.push_back (e);
+		}
+	}
+	for (int v = 0; v < n; v++)
+		offset[v + 1] += offset[v];
+
+	// Fill the lists, then sort each one by neighbour
+	std::vector<size_t> pos (offset.begin(), offset.end() - 1);
+	std::vector< std::pair<int, int> > adjacent (offset[n]);
+	for (int k = 0; k < edges.size(); k++)
+	{
+		int u = vertex_index[edges[k].source()];
+		int v = vertex_index[edges[k].target()];
+		adjacent[pos[u]++] = std::pair<int, int> (v, k);
+		adjacent[pos[v]++] = std::pair<int, int> (u, k);
+	}
+	neighbour.resize (offset[n]);
+	edge_number.resize (offset[n]);
+	for (int v = 0; v < n; v++)
+	{
+		std::sort (adjacent.begin() + offset[v], adjacent.begin() + offset[v + 1]);
+		for (size_t k = offset[v]; k < offset[v + 1]; k++)
+		{
+			neighbour[k] = adjacent[k].first;
+			edge_number[k] = adjacent[k].second;
+		}
+	}
+
+	// Bitsets are worth having if the average degree is more than the
+	// number of words in a bitset
+	words = 0;
+	bits.clear ();
+	if ((n > 0) && (n <= NEIGHBOUR_BITSET_LIMIT) && ((double)offset[n] / n > n / 64 + 1))
+	{
+		words = n / 64 + 1;
+		bits.assign ((size_t)n * words, 0);
+		for (int v = 0; v < n; v++)
+		{
+			unsigned long long *row = &bits[0] + (size_t)v * words;
+			for (size_t k = offset[v]; k < offset[v + 1]; k++)
+				row[neighbour[k] / 64] |= 1ULL << (neighbour[k] % 64);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Number of the edge joining a to its neighbour u
+int NeighbourSets::FindEdge (int a, int u) const
+{
+	const int *first = &neighbour[0] + offset[a];
+	const int *last = &neighbour[0] + offset[a + 1];
+	return edge_number[std::lower_bound (first, last, u) - &neighbour[0]];
+}
+
+//------------------------------------------------------------------------------
+void NeighbourSets::GetCommonNeighbours (int a, int b, std::vector<int> &ea, std::vector<int> &eb) const
+{
+	ea.clear ();
+	eb.clear ();
+	size_t na = offset[a + 1] - offset[a];
+	size_t nb = offset[b + 1] - offset[b];
+	if ((na == 0) || (nb == 0))
+		return;
+
+	if (!bits.empty() && (na + nb > words))
+	{
+		const unsigned long long *row_a = &bits[0] + (size_t)a * words;
+		const unsigned long long *row_b = &bits[0] + (size_t)b * words;
+		for (size_t w = 0; w < words; w++)
+		{
+			unsigned long long common = row_a[w] & row_b[w];
+			while (common != 0)
+			{
+				int u = (int)(w * 64) + __builtin_ctzll (common);
+				common &= common - 1;
+				ea.push_back (FindEdge (a, u));
+				eb.push_back (FindEdge (b, u));
+			}
+		}
+		return;
+	}
+
+	size_t i = offset[a];
+	size_t j = offset[b];
+	while ((i < offset[a + 1]) && (j < offset[b + 1]))
+	{
+		if (neighbour[i] < neighbour[j])
+			i++;
+		else if (neighbour[j] < neighbour[i])
+			j++;
+		else
+		{
+			ea.push_back (edge_number[i++]);
+			eb.push_back (edge_number[j++]);
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file neighbours.h
+ *
+ * Neighbourhoods of the vertices of a GTL graph, for finding common neighbours
+ *
+ */
+
+#ifndef NEIGHBOURSH
+#define NEIGHBOURSH
+
+#include <vector>
+
+#include <GTL/graph.h>
+#include <GTL/node_map.h>
+#include <GTL/edge_map.h>
+
+/**
+ * @def NEIGHBOUR_BITSET_LIMIT
+ * The largest number of vertices for which NeighbourSets keeps a bitset of
+ * the neighbours of each vertex.
+ */
+#define NEIGHBOUR_BITSET_LIMIT 16384
+
+/**
+ * @class NeighbourSets
+ * A read-only copy of the neighbourhoods of the vertices of an undirected GTL
+ * graph, restricted to the visible edges that do not have a given colour.
+ * Vertices are numbered 0..n-1 in the order in which GTL lists the nodes, and
+ * edges 0..m-1 in the order in which GTL lists the edges. The neighbours of
+ * vertex v, in increasing order, are neighbour[offset[v]] ... neighbour[offset[v+1]-1],
+ * and the edge joining v to neighbour[k] is number edge_number[k].
+ *
+ * If the graph is dense enough (and has no more than NEIGHBOUR_BITSET_LIMIT
+ * vertices) the neighbours of each vertex are also kept as a bitset, and the
+ * common neighbours of two vertices of high degree are found by ANDing their
+ * bitsets a word at a time. Otherwise the two sorted lists are merged.
+ *
+ * Once built the object is only read, so several threads can call
+ * GetCommonNeighbours at once.
+ */
+class NeighbourSets
+{
+public:
+	NeighbourSets () { words = 0; };
+
+	/**
+	 * @fn void Build (const graph &G, edge_map<int> &colour, int excluded)
+	 * Build the neighbourhoods of the vertices of G.
+	 * @param G the graph (unmodified)
+	 * @param colour the colours of the edges
+	 * @param excluded edges with this colour are left out
+	 */
+	void Build (const graph &G, edge_map<int> &colour, int excluded);
+	/**
+	 * @fn void GetCommonNeighbours (int a, int b, std::vector<int> &ea, std::vector<int> &eb) const
+	 * Find the vertices u that are neighbours of both a and b.
+	 * @param a a vertex
+	 * @param b another vertex
+	 * @param ea on return the numbers of the edges (a,u), one for each common neighbour u
+	 * @param eb on return the numbers of the edges (b,u), in the same order as ea
+	 */
+	void GetCommonNeighbours (int a, int b, std::vector<int> &ea, std::vector<int> &eb) const;
+
+	/**
+	 * @fn int GetNumVertices () const
+	 * @return the number of vertices
+	 */
+	int GetNumVertices () const { return (int)offset.size() - 1; };
+	/**
+	 * @fn int GetNumEdges () const
+	 * @return the number of edges
+	 */
+	int GetNumEdges () const { return (int)edges.size(); };
+	/**
+	 * @fn int GetIndex (node n) const
+	 * @return the vertex number of node n
+	 */
+	int GetIndex (node n) const { return vertex_index[n]; };
+	/**
+	 * @fn edge GetEdge (int k) const
+	 * @return the GTL edge numbered k
+	 */
+	edge GetEdge (int k) const { return edges[k]; };
+
+protected:
+	node_map<int>						vertex_index;
+	std::vector<edge>					edges;
+	std::vector<size_t>					offset;
+	std::vector<int>					neighbour;
+	std::vector<int>					edge_number;
+	// If not empty, the bitset of the neighbours of v is
+	// bits[v * words],...,bits[v * words + words - 1]
+	size_t								words;
+	std::vector<unsigned long long>		bits;
+
+	int FindEdge (int a, int u) const;
+};
+
+#endif
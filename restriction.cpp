@@ -0,0 +1,99 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "restriction.h"
+#include "nodeiterator.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+TreeRestriction::TreeRestriction (std::vector<NTree> &T) : trees(T)
+{
+	for (int i = 0; i < trees.size(); i++)
+	{
+		// NodeIterator visits the leaves from left to right
+		int rank = 0;
+		NodeIterator <Node> n (trees[i].GetRoot());
+		NodePtr q = n.begin();
+		while (q)
+		{
+			if (q->IsLeaf())
+				AddPosting (q->GetLabelNumber() - 1, i, rank++, q);
+			q = n.next();
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void TreeRestriction::AddPosting (int id, int tree, int rank, NodePtr leaf)
+{
+	if (id >= (int)postings.size())
+		postings.resize (id + 1);
+	Posting p;
+	p.tree = tree;
+	p.rank = rank;
+	p.leaf = leaf;
+	postings[id].push_back (p);
+}
+
+//------------------------------------------------------------------------------
+void TreeRestriction::Find (const std::vector<int> &S, std::vector<Posting> &found) const
+{
+	for (int k = 0; k < S.size(); k++)
+	{
+		if (S[k] < (int)postings.size())
+			found.insert (found.end(), postings[S[k]].begin(), postings[S[k]].end());
+	}
+	std::sort (found.begin(), found.end());
+}
+
+//------------------------------------------------------------------------------
+void TreeRestriction::Restrict (const std::vector<int> &S, std::vector<NTree> &TS) const
+{
+	// The leaves in S, grouped by tree and in left to right order within a tree
+	std::vector<Posting> found;
+	Find (S, found);
+
+	int num_trees = 0;
+	for (int k = 0; k < found.size(); k++)
+	{
+		if ((k == 0) || (found[k].tree != found[k - 1].tree))
+			num_trees++;
+	}
+	// Reserve space so that the trees are not copied as TS grows
+	TS.reserve (TS.size() + num_trees);
+
+	int k = 0;
+	std::vector<NodePtr> leaves;
+	while (k < found.size())
+	{
+		int i = found[k].tree;
+		leaves.clear();
+		while ((k < found.size()) && (found[k].tree == i))
+			leaves.push_back (found[k++].leaf);
+
+		TS.resize (TS.size() + 1);
+		NTree &t = TS.back();
+		t.MakeInducedSubtree (trees[i], leaves);
+	}
+}
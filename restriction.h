@@ -0,0 +1,96 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file restriction.h
+ *
+ * Restrict a set of trees to a subset of the taxa
+ *
+ */
+
+#ifndef RESTRICTIONH
+#define RESTRICTIONH
+
+#include <vector>
+
+#include "ntree.h"
+
+/**
+ * @class TreeRestriction
+ * Computes T|S, the trees obtained by restricting each tree in a vector T
+ * to the taxa in a set S, for many sets S. The constructor builds a posting
+ * list for each taxon, giving the trees that contain it and its leaf in each
+ * tree. Restrict uses these lists to find the trees that contain some of S,
+ * without looking at the other trees, and builds each restricted tree with
+ * Tree::MakeInducedSubtree.
+ *
+ * The trees in T must not change while the object is in use. Restrict only
+ * reads T and the posting lists, so it can be called by several threads at
+ * once.
+ */
+class TreeRestriction
+{
+public:
+	/**
+	 * Build the posting lists for T.
+	 * @param T the trees, whose leaf label numbers and node degrees must be set
+	 */
+	TreeRestriction (std::vector<NTree> &T);
+
+	/**
+	 * Compute T|S.
+	 * @param S the taxon ids (leaf label number - 1) in S
+	 * @param TS on return the trees in T that contain some of S, in the same
+	 * order as in T, each restricted to the leaves in S. Node degrees are set,
+	 * but the clusters must be built with BuildLabelClusters before they are used
+	 */
+	void Restrict (const std::vector<int> &S, std::vector<NTree> &TS) const;
+
+protected:
+	/**
+	 * @struct Posting
+	 * The leaf for a taxon in tree number tree. rank is the position of
+	 * the leaf in a left to right order of the leaves of the tree.
+	 */
+	struct Posting
+	{
+		int		tree;
+		int		rank;
+		NodePtr	leaf;
+
+		bool operator< (const Posting &p) const
+		{
+			return (tree < p.tree) || ((tree == p.tree) && (rank < p.rank));
+		};
+	};
+
+	// Gather the postings for S, grouped by tree and sorted by rank
+	void Find (const std::vector<int> &S, std::vector<Posting> &found) const;
+	void AddPosting (int id, int tree, int rank, NodePtr leaf);
+
+	std::vector<NTree> &trees;
+	// postings[id] lists the leaves labelled with taxon id
+	std::vector< std::vector<Posting> > postings;
+};
+
+#endif
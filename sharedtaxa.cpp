@@ -0,0 +1,145 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "sharedtaxa.h"
+
+#include <algorithm>
+
+#include "clusterset.h"
+
+//------------------------------------------------------------------------------
+// Count the taxa shared with each earlier tree using the trees that contain
+// each taxon, in increasing order
+static void FindSharedTaxaInverted (const std::vector< std::vector<int> > &taxa, int ntax, int k,
+	std::vector<SharedTaxa> &pairs)
+{
+	std::vector< std::vector<int> > trees (ntax + 1);
+	for (int i = 0; i < (int)taxa.size(); i++)
+	{
+		for (size_t t = 0; t < taxa[i].size(); t++)
+			trees[taxa[i][t]].push_back (i);
+	}
+
+	std::vector<int> count (taxa.size(), 0);
+	std::vector<int> touched;
+	std::vector<int> position (ntax + 1, 0);	// trees[x][position[x]] is tree i
+	for (int i = 0; i < (int)taxa.size(); i++)
+	{
+		touched.clear();
+		for (size_t t = 0; t < taxa[i].size(); t++)
+		{
+			int x = taxa[i][t];
+			const int *j = trees[x].empty() ? NULL : &trees[x][0];
+			const int *end = j + position[x]++;
+			for (; j < end; j++)
+			{
+				if (count[*j]++ == 0)
+					touched.push_back (*j);
+			}
+		}
+		std::sort (touched.begin(), touched.end());
+		for (size_t n = 0; n < touched.size(); n++)
+		{
+			int j = touched[n];
+			if (count[j] >= k)
+			{
+				SharedTaxa s;
+				s.i = i;
+				s.j = j;
+				s.w = count[j];
+				pairs.push_back (s);
+			}
+			count[j] = 0;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Compare the bitsets of the taxa of every pair of trees
+static void FindSharedTaxaBitsets (const std::vector< std::vector<int> > &taxa, int ntax, int k,
+	std::vector<SharedTaxa> &pairs)
+{
+	size_t words = (size_t)ntax / 64 + 1;
+	std::vector<unsigned long long> bits (taxa.size() * words, 0);
+	// Only the words from first[i] to last[i] of tree i can be non-zero
+	std::vector<size_t> first (taxa.size(), words);
+	std::vector<size_t> last (taxa.size(), 0);
+	for (size_t i = 0; i < taxa.size(); i++)
+	{
+		unsigned long long *b = &bits[0] + i * words;
+		for (size_t t = 0; t < taxa[i].size(); t++)
+		{
+			size_t w = taxa[i][t] / 64;
+			b[w] |= 1ULL << (taxa[i][t] % 64);
+			first[i] = std::min (first[i], w);
+			last[i] = std::max (last[i], w + 1);
+		}
+	}
+
+	for (size_t i = 1; i < taxa.size(); i++)
+	{
+		const unsigned long long *a = &bits[0] + i * words;
+		for (size_t j = 0; j < i; j++)
+		{
+			const unsigned long long *b = &bits[0] + j * words;
+			size_t from = std::max (first[i], first[j]);
+			size_t to = std::min (last[i], last[j]);
+			int w = 0;
+			for (size_t n = from; n < to; n++)
+				w += ClusterSet::PopCount (a[n] & b[n]);
+			if (w >= k)
+			{
+				SharedTaxa s;
+				s.i = (int)i;
+				s.j = (int)j;
+				s.w = w;
+				pairs.push_back (s);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void FindSharedTaxa (const std::vector< std::vector<int> > &taxa, int ntax, int k,
+	std::vector<SharedTaxa> &pairs)
+{
+	pairs.clear();
+
+	// Pairs of trees that share each taxon, and pairs of trees times words
+	std::vector<double> frequency (ntax + 1, 0.0);
+	for (size_t i = 0; i < taxa.size(); i++)
+	{
+		for (size_t t = 0; t < taxa[i].size(); t++)
+			frequency[taxa[i][t]] += 1.0;
+	}
+	double increments = 0.0;
+	for (int x = 0; x <= ntax; x++)
+		increments += frequency[x] * (frequency[x] - 1.0) / 2.0;
+	double n = (double)taxa.size();
+	double comparisons = n * (n - 1.0) / 2.0 * (double)(ntax / 64 + 1);
+
+	if ((k < 1) || (comparisons < SHARED_TAXA_INCREMENT_COST * increments))
+		FindSharedTaxaBitsets (taxa, ntax, k, pairs);
+	else
+		FindSharedTaxaInverted (taxa, ntax, k, pairs);
+}
@@ -0,0 +1,77 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file sharedtaxa.h
+ *
+ * Find the pairs of trees that share at least k taxa
+ *
+ */
+
+#ifndef SHAREDTAXAH
+#define SHAREDTAXAH
+
+#include <vector>
+
+/**
+ * @def SHARED_TAXA_INCREMENT_COST
+ * The cost of adding one to the count of a pair of trees using the inverted
+ * index, relative to the cost of comparing one 64-bit word of two bitsets.
+ */
+#define SHARED_TAXA_INCREMENT_COST 4
+
+/**
+ * @struct SharedTaxa
+ * Trees i and j (j < i) have w taxa in common
+ */
+struct SharedTaxa
+{
+	int i;
+	int j;
+	int w;
+};
+
+/**
+ * @fn void FindSharedTaxa (const std::vector< std::vector<int> > &taxa, int ntax, int k, std::vector<SharedTaxa> &pairs)
+ * @brief find the pairs of trees that have at least k taxa in common
+ *
+ * There are two methods, and the one with the lower estimated cost is used.
+ * The inverted index lists the trees that contain each taxon. For each tree i
+ * the lists of its taxa are scanned for trees j < i, and the number of taxa
+ * shared with each j is counted, so only pairs of trees that share a taxon
+ * are looked at. This costs the sum over taxa of the number of pairs of trees
+ * that contain the taxon. The other method stores the taxa of each tree as
+ * a bitset, and counts the taxa shared by each pair of trees with popcount,
+ * which costs one operation per word for every pair. If k < 1 every pair of
+ * trees is a result, and the bitsets are used.
+ *
+ * @param taxa taxa[i] is the taxa in tree i, as numbers 1,...,ntax with no repeats
+ * @param ntax the largest taxon number
+ * @param k the least number of taxa a pair of trees must share
+ * @param pairs set to the pairs (i,j) with j < i that share at least k taxa, and
+ * the number they share, sorted by i then j
+ */
+void FindSharedTaxa (const std::vector< std::vector<int> > &taxa, int ntax, int k,
+	std::vector<SharedTaxa> &pairs);
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "stbuild.h"
+
+#include <algorithm>
+
+/**
+ * @struct PairMatrix
+ * Weights and frequencies of the pairs (i,j), i < j, of n taxa, stored row by
+ * row in triangular arrays. first[k] is the first cluster that contains pair k.
+ * The clusters are stored as sorted lists of matrix rows, cluster c being
+ * members[start[c]] ... members[start[c+1]-1].
+ */
+struct PairMatrix
+{
+	long long			n;
+	std::vector<int>	weight;
+	std::vector<int>	freq;
+	std::vector<int>	first;
+	std::vector<int>	members;
+	std::vector<size_t>	start;
+
+	// Position of pair (i,j) is Base (i) + j
+	long long Base (long long i) const { return i * (2 * n - i - 1) / 2 - i - 1; };
+};
+
+//------------------------------------------------------------------------------
+// Add the pairs whose first taxon is in rows first_row,...,last_row-1
+static void FillRows (PairMatrix &M, const std::vector<int> &weights, int first_row, int last_row)
+{
+	for (size_t c = 0; c + 1 < M.start.size(); c++)
+	{
+		const int *b = &M.members[0] + M.start[c];
+		const int *e = &M.members[0] + M.start[c + 1];
+		if (e - b < 2)
+			continue;
+		int w = weights[c];
+		for (const int *a = std::lower_bound (b, e, first_row); (a < e) && (*a < last_row); a++)
+		{
+			long long base = M.Base (*a);
+			int *row_weight = &M.weight[0] + base;
+			int *row_freq = &M.freq[0] + base;
+			int *row_first = &M.first[0] + base;
+			for (const int *q = a + 1; q < e; q++)
+			{
+				if (row_freq[*q]++ == 0)
+					row_first[*q] = (int)c;
+				row_weight[*q] += w;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void BuildSTGraph (STGraph &ST, const std::vector<const ClusterSet *> &clusters,
+	const std::vector<int> &weights, ThreadPool *pool)
+{
+	// Which taxa are present, and how many pairs the clusters contain
+	int max_element = 0;
+	double num_pairs = 0.0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		if (!clusters[c]->empty())
+		{
+			int last = 0;
+			for (ClusterSet::iterator it = clusters[c]->begin(); it != clusters[c]->end(); ++it)
+				last = *it;
+			max_element = std::max (max_element, last);
+		}
+		double k = clusters[c]->size();
+		num_pairs += k * (k - 1.0) / 2.0;
+	}
+	std::vector<int> row (max_element + 1, -1);
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		for (ClusterSet::iterator it = clusters[c]->begin(); it != clusters[c]->end(); ++it)
+			row[*it] = 0;
+	}
+	std::vector<int> element;
+	for (int i = 0; i <= max_element; i++)
+	{
+		if (row[i] == 0)
+		{
+			row[i] = (int)element.size();
+			element.push_back (i);
+		}
+	}
+	long long n = (long long)element.size();
+	double matrix_size = (double)n * (double)(n - 1) / 2.0;
+
+	// A sparse set of pairs is quicker to add one at a time, and a large
+	// matrix would take too much memory. Each entry is a weight, a
+	// frequency and a first cluster.
+	double matrix_bytes = matrix_size * 3.0 * sizeof (int);
+	if ((matrix_bytes > ST_DENSE_BYTES) || (matrix_size > ST_DENSE_RATIO * num_pairs))
+	{
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			if (clusters[c]->size() == 1)
+				ST.AddNode (*clusters[c]->begin() - 1);
+			ClusterSet::iterator iend = clusters[c]->end();
+			for (ClusterSet::iterator iit = clusters[c]->begin(); iit != iend; ++iit)
+			{
+				ClusterSet::iterator jit = iit;
+				for (++jit; jit != iend; ++jit)
+					ST.AddEdge ((*iit) - 1, (*jit) - 1, weights[c]);
+			}
+		}
+		return;
+	}
+
+	// Nodes are created in order of first appearance. Within a cluster this
+	// is the order of the elements.
+	PairMatrix M;
+	M.n = n;
+	M.start.push_back (0);
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		for (ClusterSet::iterator it = clusters[c]->begin(); it != clusters[c]->end(); ++it)
+		{
+			ST.AddNode (*it - 1);
+			M.members.push_back (row[*it]);
+		}
+		M.start.push_back (M.members.size());
+	}
+	if (n < 2)
+		return;
+
+	size_t size = (size_t)matrix_size;
+	M.weight.assign (size, 0);
+	M.freq.assign (size, 0);
+	M.first.assign (size, 0);
+
+	if (pool != NULL)
+	{
+		// Split the rows into blocks with roughly the same number of pairs
+		int num_tasks = 4 * pool->GetNumThreads();
+		TaskGroup group;
+		long long per_task = (long long)size / num_tasks + 1;
+		int first_row = 0;
+		long long pairs = 0;
+		for (int i = 0; i < n; i++)
+		{
+			pairs += n - 1 - i;
+			if ((pairs >= per_task) || (i == n - 1))
+			{
+				int last_row = i + 1;
+				pool->Submit (group, [&M, &weights, first_row, last_row]
+					{ FillRows (M, weights, first_row, last_row); });
+				first_row = last_row;
+				pairs = 0;
+			}
+		}
+		pool->Wait (group);
+	}
+	else
+		FillRows (M, weights, 0, (int)n);
+
+	// Sort the edges by the first cluster they appear in, then by row
+	// and column, which is the order AddEdge would have created them in
+	std::vector<size_t> bucket (clusters.size() + 1, 0);
+	for (size_t k = 0; k < size; k++)
+	{
+		if (M.freq[k] > 0)
+			bucket[M.first[k] + 1]++;
+	}
+	for (size_t c = 1; c < bucket.size(); c++)
+		bucket[c] += bucket[c - 1];
+	std::vector< std::pair<int, int> > order (bucket.back());
+	for (long long i = 0; i < n; i++)
+	{
+		long long base = M.Base (i);
+		for (long long j = i + 1; j < n; j++)
+		{
+			long long k = base + j;
+			if (M.freq[k] > 0)
+				order[bucket[M.first[k]]++] = std::pair<int, int> ((int)i, (int)j);
+		}
+	}
+
+	for (size_t e = 0; e < order.size(); e++)
+	{
+		int i = order[e].first;
+		int j = order[e].second;
+		long long k = M.Base (i) + j;
+		ST.NewEdge (element[i] - 1, element[j] - 1, M.weight[k], M.freq[k]);
+	}
+}
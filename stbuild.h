@@ -0,0 +1,80 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file stbuild.h
+ *
+ * Build the graph ST from the clusters of the children of the roots of the trees
+ *
+ */
+
+#ifndef STBUILDH
+#define STBUILDH
+
+#include <vector>
+
+#include "clusterset.h"
+#include "threadpool.h"
+#include "stgraph.h"
+
+/**
+ * @def ST_DENSE_BYTES
+ * The most memory BuildSTGraph will use for a dense matrix of edge weights.
+ * The matrix is built at every level of the recursion, and by several threads
+ * at once with -j, so this is kept small.
+ */
+#define ST_DENSE_BYTES (32.0 * 1024.0 * 1024.0)
+
+/**
+ * @def ST_DENSE_RATIO
+ * BuildSTGraph only uses a dense matrix if it has no more than ST_DENSE_RATIO
+ * entries for each pair of taxa in the clusters.
+ */
+#define ST_DENSE_RATIO 4.0
+
+/**
+ * @fn void BuildSTGraph (STGraph &ST, const std::vector<const ClusterSet *> &clusters, const std::vector<int> &weights, ThreadPool *pool)
+ * @brief add the nodes and edges of ST for a set of clusters
+ *
+ * @param ST the graph, which should be empty
+ * @param clusters the clusters of the children of the root of each tree, in
+ * order. The elements are leaf label numbers, and element i is the node for
+ * taxon id i-1. A cluster with one element is a leaf, which adds a node but no edges.
+ * @param weights weights[k] is the weight of the tree that clusters[k] comes from
+ * @param pool if not NULL, the thread pool used to fill the matrix of weights
+ *
+ * Each pair of taxa {i,j} in a cluster adds the weight of its tree to the edge (i,j),
+ * and one to its frequency, exactly as calling STGraph::AddEdge for each pair
+ * in turn would. Nodes and edges are created in the same order as that sequence of calls.
+ *
+ * If the clusters cover enough of the possible pairs of taxa (ST_DENSE_RATIO)
+ * and the matrix fits in ST_DENSE_BYTES, the weights and frequencies are summed
+ * in a triangular matrix with one row per taxon, and the edges are then created
+ * in one pass over the matrix. The rows are split into
+ * blocks, one per task, so threads never write to the same part of the matrix
+ * and no reduction is needed. Otherwise the edges are added with STGraph::AddEdge.
+ */
+void BuildSTGraph (STGraph &ST, const std::vector<const ClusterSet *> &clusters,
+	const std::vector<int> &weights, ThreadPool *pool);
+
+#endif
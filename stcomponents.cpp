@@ -0,0 +1,133 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "stcomponents.h"
+
+#include <GTL/node_map.h>
+
+//------------------------------------------------------------------------------
+void STComponents::Find (STGraph &G)
+{
+	nodes.clear ();
+	offset.clear ();
+	node_map<int> visited (G, 0);
+
+	// Depth first search from each node not yet visited, using a stack of
+	// nodes and the next of their edges to look at in place of recursion
+	std::vector< std::pair<node, node::adj_edges_iterator> > stack;
+	graph::node_iterator nit = G.nodes_begin();
+	graph::node_iterator nend = G.nodes_end();
+	while (nit != nend)
+	{
+		if (visited[*nit] == 0)
+		{
+			offset.push_back ((int)nodes.size());
+			visited[*nit] = 1;
+			nodes.push_back (*nit);
+			stack.push_back (std::make_pair (*nit, nit->adj_edges_begin()));
+			while (!stack.empty())
+			{
+				node v = stack.back().first;
+				if (stack.back().second == v.adj_edges_end())
+				{
+					stack.pop_back ();
+					continue;
+				}
+				node u = v.opposite (*stack.back().second);
+				stack.back().second++;
+				if (visited[u] == 0)
+				{
+					visited[u] = 1;
+					nodes.push_back (u);
+					stack.push_back (std::make_pair (u, u.adj_edges_begin()));
+				}
+			}
+		}
+		nit++;
+	}
+	offset.push_back ((int)nodes.size());
+	FillTaxa (G);
+}
+
+//------------------------------------------------------------------------------
+void STComponents::FindFromIds (STGraph &G)
+{
+	// Number the components in order of their first node
+	std::vector<node> order;
+	std::vector<int> node_component;
+	std::vector<int> root_component;
+	int n = 0;
+	graph::node_iterator nit = G.nodes_begin();
+	graph::node_iterator nend = G.nodes_end();
+	while (nit != nend)
+	{
+		int root = G.GetIdComponent (G.node_ids[*nit]);
+		if (root >= (int)root_component.size())
+			root_component.resize (root + 1, -1);
+		if (root_component[root] == -1)
+			root_component[root] = n++;
+		order.push_back (*nit);
+		node_component.push_back (root_component[root]);
+		nit++;
+	}
+
+	// Group the nodes by component
+	offset.assign (n + 1, 0);
+	for (int k = 0; k < node_component.size(); k++)
+		offset[node_component[k] + 1]++;
+	for (int c = 0; c < n; c++)
+		offset[c + 1] += offset[c];
+	std::vector<int> pos (offset.begin(), offset.end() - 1);
+	nodes.resize (order.size());
+	for (int k = 0; k < order.size(); k++)
+		nodes[pos[node_component[k]]++] = order[k];
+	FillTaxa (G);
+}
+
+//------------------------------------------------------------------------------
+// List the taxa in the node sets of the nodes of each component
+void STComponents::FillTaxa (STGraph &G)
+{
+	taxon.clear ();
+	taxon_offset.clear ();
+	component.clear ();
+	for (int c = 0; c < GetNumComponents(); c++)
+	{
+		taxon_offset.push_back ((int)taxon.size());
+		for (int k = offset[c]; k < offset[c + 1]; k++)
+		{
+			NodeSet::iterator sit = G.ns[nodes[k]].begin();
+			NodeSet::iterator send = G.ns[nodes[k]].end();
+			while (sit != send)
+			{
+				int id = G.node_ids[*sit];
+				taxon.push_back (id);
+				if (id >= (int)component.size())
+					component.resize (id + 1, -1);
+				component[id] = c;
+				sit++;
+			}
+		}
+	}
+	taxon_offset.push_back ((int)taxon.size());
+}
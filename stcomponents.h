@@ -0,0 +1,119 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file stcomponents.h
+ *
+ * Connected components of ST, held as flat arrays
+ *
+ */
+
+#ifndef STCOMPONENTSH
+#define STCOMPONENTSH
+
+#include <vector>
+
+#include "stgraph.h"
+
+/**
+ * @class STComponents
+ * The connected components of the visible part of an STGraph. The nodes of
+ * component c are nodes[offset[c]] ... nodes[offset[c+1]-1], and the taxa that
+ * those nodes stand for (the members of their node sets) are
+ * taxon[taxon_offset[c]] ... taxon[taxon_offset[c+1]-1]. component[id] is the
+ * component containing taxon id, or -1 if the taxon is not in the graph.
+ *
+ * The components are numbered in the order of their first node in the list
+ * of nodes of the graph, which is the order in which GTL's components
+ * algorithm finds them.
+ */
+class STComponents
+{
+public:
+	STComponents () {};
+
+	/**
+	 * @fn void Find (STGraph &G)
+	 * Find the components by a depth first search of G. The nodes of each
+	 * component are in the preorder of the search, which visits the edges of
+	 * a node in the order GTL lists them, as GTL's components algorithm does.
+	 * @param G the graph (unmodified)
+	 */
+	void Find (STGraph &G);
+	/**
+	 * @fn void FindFromIds (STGraph &G)
+	 * Take the components from the union-find G keeps as edges are added by
+	 * taxon id, without a traversal of G. This is only correct if no node or
+	 * edge has been hidden, deleted or merged since. The nodes of each
+	 * component are in the order of the list of nodes of G.
+	 * @param G the graph
+	 */
+	void FindFromIds (STGraph &G);
+
+	/**
+	 * @fn int GetNumComponents () const
+	 * @return the number of components
+	 */
+	int GetNumComponents () const { return (int)offset.size() - 1; };
+	/**
+	 * @fn void GetTaxa (int c, std::vector<int> &ids) const
+	 * @param c a component
+	 * @param ids on return the taxa in component c
+	 */
+	void GetTaxa (int c, std::vector<int> &ids) const
+	{
+		ids.assign (taxon.begin() + taxon_offset[c], taxon.begin() + taxon_offset[c + 1]);
+	};
+
+	/**
+	 * @var nodes
+	 * Nodes grouped by component
+	 */
+	std::vector<node>	nodes;
+	/**
+	 * @var offset
+	 * offset[c] is the position of the first node of component c in nodes,
+	 * offset[n] is the number of nodes.
+	 */
+	std::vector<int>	offset;
+	/**
+	 * @var taxon
+	 * Taxon ids grouped by component
+	 */
+	std::vector<int>	taxon;
+	/**
+	 * @var taxon_offset
+	 * taxon_offset[c] is the position of the first taxon of component c in taxon
+	 */
+	std::vector<int>	taxon_offset;
+	/**
+	 * @var component
+	 * The component of each taxon id, or -1
+	 */
+	std::vector<int>	component;
+
+protected:
+	void FillTaxa (STGraph &G);
+};
+
+#endif
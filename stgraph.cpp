@@ -88,6 +88,71 @@ void STGraph::AddEdge (std::string s1, std::string s2, int weight)
 	
 }
 
+//------------------------------------------------------------------------------
+node STGraph::AddNode (int id)
+{
+	if (id >= (int)id_nodes.size())
+		id_nodes.resize (id + 1);
+	node n = id_nodes[id];
+	if (n == node())
+	{
+		n = new_node ();
+		id_nodes[id] = n;
+		node_ids[n] = id;
+		if (id >= id_components.GetSize())
+			id_components.Resize (id + 1);
+		num_id_components++;
+		if (id_labels != NULL)
+			node_labels[n] = (*id_labels)[id];
+	}
+	return n;
+}
+
+//------------------------------------------------------------------------------
+void STGraph::AddEdge (int id1, int id2, int weight)
+{
+	node n1 = AddNode (id1);
+	node n2 = AddNode (id2);
+
+	unordered_map<unsigned long long, edge>::iterator it = id_edges.find (IdPairKey (id1, id2));
+	if (it != id_edges.end())
+	{
+		// Increment weight of existing edge
+		w0[it->second] += weight;	
+		f[it->second] += 1;
+	}
+	else
+	{
+		edge e = new_edge (n1, n2);
+		w0[e] = weight;
+		f[e] = 1;
+		id_edges[IdPairKey (id1, id2)] = e;
+		if (id_components.Union (id1, id2))
+			num_id_components--;
+	}
+}
+
+//------------------------------------------------------------------------------
+void STGraph::NewEdge (int id1, int id2, int weight, int freq)
+{
+	edge e = new_edge (id_nodes[id1], id_nodes[id2]);
+	w0[e] = weight;
+	f[e] = freq;
+	id_edges[IdPairKey (id1, id2)] = e;
+	if (id_components.Union (id1, id2))
+		num_id_components--;
+}
+
+//------------------------------------------------------------------------------
+int STGraph::GetEdgeFreq (int id1, int id2) const
+{
+	int result = 0;
+	unordered_map<unsigned long long, edge>::const_iterator it = id_edges.find (IdPairKey (id1, id2));
+	if (it != id_edges.end())
+		result = f[it->second];
+	return result;
+}
+
 //------------------------------------------------------------------------------
 bool STGraph::EdgeExists (node n1, node n2)
 {
@@ -111,53 +176,6 @@ bool STGraph::EdgeExists (node n1, node n2)
 	return result;
 }
 
-//------------------------------------------------------------------------------
-int STGraph::GetEdgeFreqFromNodeLabels (std::string s1, std::string s2)
-{
-	int result = 0;
-	bool both_nodes_exist = true;
-	node n1, n2;
-
-	if (labelled_nodes.find (s1) == labelled_nodes.end ())
-	{
-		both_nodes_exist = false;
-	}
-	else
-	{
-		n1 = labelled_nodes[s1];
-	}
-
-	if (labelled_nodes.find (s2) == labelled_nodes.end ())
-	{
-		both_nodes_exist = false;
-	}
-	else
-	{
-		n2 = labelled_nodes[s2];
-	}
-
-	if (both_nodes_exist)
-	{	
-		// Is there an edge connecting n1 and n2?
-	   	node::adj_edges_iterator eit = n1.adj_edges_begin();
-		node::adj_edges_iterator eend = n1.adj_edges_end();
-		node found = n1;
-		while ((found == n1) && (eit != eend))
-		{
-			if (n1.opposite (*eit) == n2)
-				found = n2;
-			else
-				eit++;
-		}
-		if (found == n2)
-		{
-			result = f[*eit];
-		}
-	}
-	return result;
-}
-
-
 
 //------------------------------------------------------------------------------
 void STGraph::post_new_node_handler (node n)
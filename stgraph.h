@@ -27,10 +27,15 @@
 // STL
 #include <map>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // GTL
 #include <GTL/graph.h>
 
+#include "unionfind.h"
+
 
 typedef set<node, less<node> > NodeSet;
 
@@ -54,7 +59,7 @@ typedef set<node, less<node> > NodeSet;
 class STGraph : public graph
 {
 public:
-	STGraph () { mShowLabels = false; mShowColours = false; };
+	STGraph () { mShowLabels = false; mShowColours = false; id_labels = NULL; num_id_components = 0; };
 		
 
 	/** 
@@ -91,6 +96,11 @@ public:
 	 * A map between nodes and a label string. This allows us to access the label of a node.
 	 */
 	node_map <std::string> node_labels;
+	/**
+	 * A map between nodes and the taxon id of nodes added by id.
+	 * @sa AddNode (int)
+	 */
+	node_map <int> node_ids;
 	/**
 	 * A map between nodes and a label string. This allows us to refer to
 	 * a node by its label.
@@ -112,10 +122,73 @@ public:
 	 */
 	virtual void AddNode (std::string s);
 	
+	/**
+	 * Set the labels used for nodes added by taxon id. The label of taxon i is
+	 * labels[i]. The vector is not copied, so it must outlive the graph.
+	 * @param labels the taxon labels, in the order of the indices
+	 * Profile assigns to them
+	 */
+	virtual void SetLabels (const std::vector<std::string> *labels) { id_labels = labels; };
+	/**
+	 * Add a node for taxon id to the graph, unless the node already exists.
+	 * The label of the node is only looked up when the node is created.
+	 * @param id the taxon id (the index Profile assigns to the label)
+	 * @return the node for taxon id
+	 */
+	virtual node AddNode (int id);
+	/**
+	 * Add an edge between the nodes for taxa id1 and id2, creating the nodes
+	 * if needed. If there is already an edge connecting the two nodes, increment
+	 * the weight of that edge. Finding the edge takes constant time, rather than
+	 * a scan of the adjacency list of one of the nodes.
+	 * @param id1 id of first taxon
+	 * @param id2 id of second taxon
+	 * @param weight weight of edge (default is 1)
+	 */
+	virtual void AddEdge (int id1, int id2, int weight = 1);
+	/**
+	 * Add a new edge between the nodes for taxa id1 and id2, which must already
+	 * exist and must not already be joined by an edge.
+	 * @param id1 id of first taxon
+	 * @param id2 id of second taxon
+	 * @param weight weight of edge
+	 * @param freq frequency of edge
+	 */
+	virtual void NewEdge (int id1, int id2, int weight, int freq);
+	/**
+	 * @param id1 id of first taxon
+	 * @param id2 id of second taxon
+	 * @return the frequency of the edge between taxa id1 and id2, or 0
+	 * if there is no such edge
+	 */
+	virtual int GetEdgeFreq (int id1, int id2) const;
+	/**
+	 * The number of connected components of the graph made by AddNode (int),
+	 * AddEdge (int, int, int) and NewEdge. This is kept up to date as the nodes
+	 * and edges are added, so no traversal of the graph is needed, but nodes and
+	 * edges that are later hidden, deleted or merged are not taken into account.
+	 * @return the number of components
+	 */
+	int GetNumIdComponents () const { return num_id_components; };
+	/**
+	 * @param id a taxon id in the graph
+	 * @return the taxon id that stands for the component containing id, as
+	 * counted by GetNumIdComponents
+	 */
+	int GetIdComponent (int id) { return id_components.Find (id); };
+	/**
+	 * @return one more than the largest taxon id added to the graph
+	 */
+	int GetNumIds () const { return (int)id_nodes.size(); };
+	/**
+	 * @param id a taxon id
+	 * @return the node for taxon id, or an invalid node if the taxon was not
+	 * added to the graph
+	 */
+	node GetIdNode (int id) const { return (id < (int)id_nodes.size()) ? id_nodes[id] : node(); };
+	
 	virtual bool EdgeExists (node n1, node n2);
 
-	virtual int GetEdgeFreqFromNodeLabels (std::string s1, std::string s2);
-	
 	virtual int GetCommonNeighbours (edge e, NodeSet &common_set);
 	
 	/**
@@ -171,7 +244,33 @@ public:
 	 */
 	virtual void WriteDotty (const char *fname);
 
+protected:
+	/**
+	 * Labels of the taxa, indexed by taxon id
+	 */
+	const std::vector<std::string> *id_labels;
+	/**
+	 * The node for each taxon id added to the graph (an invalid node if the taxon
+	 * is not in the graph)
+	 */
+	std::vector<node> id_nodes;
+	/**
+	 * Edges added by AddEdge (int, int, int), keyed by the pair of taxon ids.
+	 * Edges created by mergeNodes are not indexed.
+	 */
+	std::unordered_map<unsigned long long, edge> id_edges;
+	/**
+	 * Taxa joined by paths of edges added by taxon id
+	 */
+	UnionFind id_components;
+	int num_id_components;
 	
+	unsigned long long IdPairKey (int id1, int id2) const
+	{
+		if (id1 > id2)
+			std::swap (id1, id2);
+		return ((unsigned long long)id1 << 32) | (unsigned int)id2;
+	};
 };	
 
 #endif
\ No newline at end of file
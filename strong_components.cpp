@@ -1,81 +1,88 @@
 #include "strong_components.h"
 
-#include <stack>
-
-typedef stack<node> node_list;
-
-static void scc_dfs(const graph& G, node v, node_map<int>& compnum,
-                                            node_map<int>& dfsnum,
-                                            node_list& unfinished,
-                                            node_list & roots,
-                                            int& count1, int& count2, node_map<bool> &is_unfinished );
-
-static void scc_dfs(const graph& G, node v, node_map<int>& compnum,
-                                            node_map<int>& dfsnum,
-                                            node_list& unfinished,
-                                            node_list & roots,
-                                            int& count1, int& count2, node_map<bool> &is_unfinished )
-{
-	node w;
-
-	dfsnum[v] = ++count1;
-	unfinished.push(v);
-	is_unfinished[v] = true;
-	roots.push(v);
-
-	node::adj_nodes_iterator it = v.adj_nodes_begin();
-	while (it != v.adj_nodes_end())
-    { 
-    	node w = *it;
-		if (dfsnum[w]==-1) 
-			scc_dfs(G,w,compnum,dfsnum,unfinished,roots,count1,count2, is_unfinished);
-		else 
-			if (is_unfinished[w])
-				while (dfsnum[roots.top()] > dfsnum[w])  
-					roots.pop();
-		it++;
-	}
-
-	if (v == roots.top()) 
-	{ 
-		do { 
-			w = unfinished.top();
-			unfinished.pop();
-			is_unfinished[w] = false;
-          	/* w is an element of the scc with root v */
-          	compnum[w] = count2;
-		} while (v != w);
-     	count2++;
-     	roots.pop(); 
-	}
-}
-
-
-
-
-  // int STRONG_COMPONENTS(graph& G, node_m<int>& compnum)
-  // computes strong connected components (scc) of digraph G
-  // returns m = number of scc 
-  // returns in node_array<int> compnum for each node an integer with
-  // compnum[v] = compnum[w] iff v and w belong to the same scc
-  // 0 <= compnum[v] <= m-1 for all nodes v
-
-int STRONG_COMPONENTS(const graph& G, node_map<int>& compnum)
+#define NO_VERTEX ((csr_index)-1)
+
+//------------------------------------------------------------------------------
+// Tarjan's algorithm. This follows the recursive scc_dfs that used to live in
+// this file, with the recursion replaced by a stack of vertices. next_arc[v] is
+// the next arc of v to look at when we return to v.
+int StrongComponents::Run (csr_index n, const csr_index *offset, const CSRArc *arcs,
+	const int *cap, std::vector<int> &compnum)
 {
-
-	node_list      roots;
-	node_list      unfinished;
-	node_map<bool> is_unfinished (G, false);
-	node_map<int> dfsnum(G,-1);
-
- 	int count1 = 0; 
+	compnum.resize (n);
+	dfsnum.assign (n, -1);
+	is_unfinished.assign (n, 0);
+	next_arc.resize (n);
+	stack.clear();
+	roots.clear();
+	unfinished.clear();
+	stack.reserve (n);
+	roots.reserve (n);
+	unfinished.reserve (n);
+
+	int count1 = 0;
 	int count2 = 0;
 
-	node v;
-
-	forall_nodes(v,G) 
-		if (dfsnum[v] == -1) 
-			scc_dfs(G,v,compnum,dfsnum,unfinished,roots,count1,count2, is_unfinished);
-
+	for (csr_index s = 0; s < n; s++)
+	{
+		if (dfsnum[s] != -1)
+			continue;
+
+		csr_index v = s;
+		for (;;)
+		{
+			if (v != NO_VERTEX)
+			{
+				// First visit to v
+				dfsnum[v] = ++count1;
+				unfinished.push_back (v);
+				is_unfinished[v] = 1;
+				roots.push_back (v);
+				next_arc[v] = offset[v];
+				stack.push_back (v);
+			}
+			if (stack.empty())
+				break;
+
+			csr_index u = stack.back();
+			csr_index end = offset[u + 1];
+			csr_index a = next_arc[u];
+			v = NO_VERTEX;
+			while ((a < end) && (v == NO_VERTEX))
+			{
+				if ((cap == NULL) || (cap[a] > 0))
+				{
+					csr_index w = arcs[a].target;
+					if (dfsnum[w] == -1)
+						v = w;
+					else if (is_unfinished[w])
+					{
+						while (dfsnum[roots.back()] > dfsnum[w])
+							roots.pop_back();
+					}
+				}
+				a++;
+			}
+			next_arc[u] = a;
+			if (v != NO_VERTEX)
+				continue;
+
+			// All arcs of u have been looked at
+			stack.pop_back();
+			if (u == roots.back())
+			{
+				csr_index w;
+				do {
+					w = unfinished.back();
+					unfinished.pop_back();
+					is_unfinished[w] = 0;
+					/* w is an element of the scc with root u */
+					compnum[w] = count2;
+				} while (u != w);
+				count2++;
+				roots.pop_back();
+			}
+		}
+	}
 	return count2;
 }
@@ -1,12 +1,59 @@
 #ifndef STRONG_H
 #define STRONG_H
 
-#include <GTL/graph.h>
-#include <GTL/node_map.h>
-#include <stack>
+#include <vector>
 
-int STRONG_COMPONENTS(const graph& G, node_map<int>& compnum);
+#include "csrgraph.h"
 
+/**
+ * @class StrongComponents
+ * Tarjan's algorithm for the strongly connected components of a directed
+ * graph held as flat arrays. The depth first search is done with an explicit
+ * stack, so long paths can't overflow the call stack, and the work arrays
+ * are kept between calls so that the same object can be run on many graphs
+ * of the same size (e.g., the residual graphs of a series of flows) without
+ * allocating memory. Components are numbered in the same order as the
+ * recursive scc_dfs.
+ *
+ */
+class StrongComponents
+{
+public:
+	StrongComponents () {};
 
-#endif
+	/**
+	 * @fn int Run (csr_index n, const csr_index *offset, const CSRArc *arcs, const int *cap, std::vector<int> &compnum)
+	 * Find the strongly connected components of a directed graph.
+	 * @param n the number of vertices
+	 * @param offset the arcs leaving vertex v are arcs[offset[v]] ... arcs[offset[v+1]-1]
+	 * @param arcs the arcs
+	 * @param cap if not NULL, only arcs a with cap[a] > 0 are in the graph
+	 * @param compnum on return compnum[v] is the number (0,...,m-1) of
+	 * the component containing vertex v
+	 * @return m, the number of components
+	 */
+	int Run (csr_index n, const csr_index *offset, const CSRArc *arcs, const int *cap,
+		std::vector<int> &compnum);
+
+	/**
+	 * @fn int Run (const CSRGraph &G, const std::vector<int> &cap, std::vector<int> &compnum)
+	 * Find the strongly connected components of the directed graph made up of the
+	 * arcs a of G with cap[a] > 0.
+	 */
+	int Run (const CSRGraph &G, const std::vector<int> &cap, std::vector<int> &compnum)
+	{
+		return Run (G.GetNumVertices(), &G.offset[0], G.arcs.empty() ? NULL : &G.arcs[0],
+			cap.empty() ? NULL : &cap[0], compnum);
+	};
+
+protected:
+	std::vector<int>		dfsnum;
+	std::vector<csr_index>	next_arc;
+	std::vector<csr_index>	stack;
+	std::vector<csr_index>	roots;
+	std::vector<csr_index>	unfinished;
+	std::vector<char>		is_unfinished;
+};
 
+
+#endif
@@ -33,17 +33,22 @@
 #include "profile.h"
 #include "nodeiterator.h"
 #include "quartet.h"
+#include "flattree.h"
+#include "triplets.h"
+#include "threadpool.h"
+#include "profilecache.h"
 
 
 #include <GTL/graph.h>
 #include <GTL/components.h>
-#include <GTL/maxflow_ff.h> 
 #include <GTL/biconnectivity.h>
 
 #include <list>
 #include <set>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
+#include <atomic>
 
 /*
 #ifdef __GNUC__
@@ -76,7 +81,17 @@
 #define MINI_VERSION "0"
 
 #include "mincut_st.h"
-#include "strong_components.h"
+#include "maxflow.h"
+#include "mincut_cactus.h"
+#include "stbuild.h"
+#include "restriction.h"
+#include "mrpmatrix.h"
+#include "sharedtaxa.h"
+#include "cooccurrence.h"
+#include "fanpairs.h"
+#include "unionfind.h"
+#include "neighbours.h"
+#include "stcomponents.h"
 
 
 // Modified SQUID code to handle command line options
@@ -96,7 +111,11 @@ static struct opt_s OPTIONS[] = {
 	{ (char*)&"-a", true, ARG_INT },
 	{ (char*)&"-c", true, ARG_INT },		
 	{ (char*)&"-d", true, ARG_NONE },
-	{ (char*)&"-g", true, ARG_NONE }
+	{ (char*)&"-g", true, ARG_NONE },
+	{ (char*)&"-j", true, ARG_INT },
+	{ (char*)&"-e", true, ARG_INT },
+	{ (char*)&"-z", true, ARG_STRING },
+	{ (char*)&"-x", true, ARG_STRING }
 
 };
 #define NOPTIONS (sizeof(OPTIONS) / sizeof(struct opt_s))
@@ -107,7 +126,8 @@ Usage: supertree [-options] <tree-file> \n\
   Available options: \n\
      -v             show version information\n\
      -l             output taxon labels when writing GML files\n\
-     -g             write ST and ST/Emax to GML file(s)\n\
+     -g             write ST and ST/Emax to GML file(s), and the fans\n\
+                    (algorithm 1) to colours<n>.gml\n\
      -n filename    write NEXUS file \n\
      -k filename    write Newick file \n\
      -p filename    write tree to Postscript file\n\
@@ -115,8 +135,12 @@ Usage: supertree [-options] <tree-file> \n\
      -d             write ST and ST/EMax to dot files\n\
      -w             use tree weights\n\
      -m filename    write MRP matrix to file \n\
+     -x filename    write MRP matrix to binary file \n\
      -a n           algorithm \n\
      -c n           compute cluster graph for k=n \n\
+     -j n           use n threads \n\
+     -e n           method for finding edges in minimum cuts \n\
+     -z filename    write trees to a binary profile cache \n\
 ";
 
 
@@ -129,6 +153,11 @@ typedef set<node, less<node> > NodeSet;
 #define ALGORITHM_ROD1		1
 int use_algorithm; 
 
+// Methods for finding all edges in a minimum cut
+#define MINCUT_ST_PAIRS		0	// flow for each (s,t) pair found by mincut_st
+#define MINCUT_CACTUS		1	// classes of vertices in the cactus of minimum cuts
+int use_mincut			= MINCUT_ST_PAIRS;
+
 bool bSaveST 			= true;	// save ST to a GML file
 bool bShowST			= true; // show ST
 bool bSaveSTEmax		= true;	// save ST/Emax to a GML file
@@ -140,7 +169,6 @@ bool bShowVertexSets	= true; // show the components of ST (or ST/Emax)
 bool bShowRecursion		= true; // show when we call MinCutSupertree
 bool bShowConnected		= true; // show whether ST is connected
 bool bShowTS			= true; // show the tree after pruning leaves not in vertex set
-bool bShowTStest		= true; // show tests for constructing tree from vertex set
 bool bShowClusters		= true; // show clusters for input trees
 bool bShowSTEdge		= true; // show edge in ST as it is created
 bool bShowLevel			= true; // show level of recursion
@@ -157,9 +185,11 @@ bool bVerbose			= false;
 bool bWriteDot			= false; // show ST and ST/Emax as dot files
 bool bWriteGML          = false; // Write graphs using GML format
 bool bWriteMRP			= false; // Write MRP
+bool bWriteBinaryMRP	= false; // Write MRP matrix in binary (-x)
 bool bClusterGraph		= false; // Make cluster graph
 bool bWriteTS			= false; // Output trees at each step in the recursion
 bool bShowFan			= false;
+bool bWriteCache		= false; // Write a profile cache (-z)
 
 int level 				= 0;
 int graph_count			= 0;
@@ -168,6 +198,8 @@ int cluster_k			= 2; // number shared leaves for cluster graph
 
 int supertreeNodeNumber = 0;
 
+int num_threads			= 1; // number of threads (-j)
+
 
 #include "stgraph.h"
 
@@ -183,7 +215,27 @@ typedef struct {
 	int components;
 } Info;
 
-Info info;
+/**
+ * @struct MinCutStep
+ * @brief Record of a call to MinCutSupertree when the recursion runs in parallel
+ *
+ * In parallel the calls to MinCutSupertree finish in no particular order, so
+ * a call keeps what it would have output (its line in the table of steps, and
+ * the fan graph) here. Once the supertree is complete ReportSteps numbers the
+ * steps in the order the serial recursion visits them and does the output.
+ */
+struct MinCutStep
+{
+	Info info;
+	std::string fan_gml;			// GML for the fan graph (colours%d.gml), if -g
+	vector<MinCutStep *> children;	// recursive calls, in order of the components of ST
+
+	~MinCutStep ()
+	{
+		for (int i = 0; i < children.size(); i++)
+			delete children[i];
+	}
+};
 
 
 /**
@@ -201,16 +253,31 @@ typedef vector <NTree> NTreeVector;
  */
 STree superTree;
 
-STGraph CO;
+/**
+ * @var  CoOccurrence CO
+ * @brief The number of input trees each pair of taxa occurs in
+ *
+ */
+CoOccurrence CO;
+
+/**
+ * @var  ThreadPool *pool
+ * @brief Threads for solving the components of ST in parallel, NULL if serial
+ *
+ */
+ThreadPool *pool = NULL;
 
 
 /** 
- * @fn void MakeSTEmax (STGraph &ST, int wsum, Profile<NTree> &p)
+ * @fn void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step)
  * @brief Construct the graph @f$S_T /E_T^{\max }@f$ from @f$S_T@f$
  *
  * @param ST the graph @f$S_T@f$
  * @param wsum the sum of weights for all source trees
+ * @param T the trees
  * @param p the multiset of trees
+ * @param tree the supertree being built
+ * @param step record of this step if running in parallel, otherwise NULL
  *
  * Construct the graph @f$S_T /E_T^{\max }@f$ from @f$S_T@f$ by contracting all edges
  * in @f$S_T@f$ that have the maximum weight @f$w_{{\rm sum}}  = \sum\limits_{T \in T} {w(T)}@f$.
@@ -223,8 +290,11 @@ STGraph CO;
  * edges. We then iterate over the nodes in each component, merging all edges connecting 
  * all pairs of nodes in that component. Each component is then represented by a single node. The set of
  * merged nodes is stored in the node's node set.
+ *
+ * The components are found with a UnionFind over the taxon ids of the nodes, and the
+ * edges of the merged nodes are then deleted in one pass over the edges of the graph.
  */
-void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p);
+void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step);
 
 /**
  * @fn MinCutEdges (STGraph &ST, int cG)
@@ -242,7 +312,17 @@ void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p);
  * graph::hide_edge.
  */
 void MinCutEdges (STGraph &ST, int cG);
-void MinCutSupertree (NTreeVector &T, Profile<NTree> &p);
+/**
+ * @fn MinCutSupertree (NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step)
+ * @brief Build the mincut supertree for the trees T below the current node of tree
+ *
+ * @param T the trees
+ * @param p the profile the trees came from
+ * @param tree the supertree being built
+ * @param step if NULL the recursion is serial, otherwise the components of ST are
+ * solved in parallel using pool and the output of this step is stored in step
+ */
+void MinCutSupertree (NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step = NULL);
 
 /**
  * @fn AllMinCuts (STGraph &ST, list<node_pair> &st_list)
@@ -260,12 +340,25 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p);
  *   -# any edge in @f$R$@f with its ends in different strongly
  *      connected components belongs to some minimum cut
  * 
- * This algorithm is based on Picard and Queryanne.
+ * This algorithm is based on Picard and Queryanne. The flows are computed
+ * with DinicFlow on a CSRGraph copy of ST, built once for all the (s,t) pairs.
  *
  * Having found the edges we "delete" them by calling
  * graph::hide_edge.
  */
 void AllMinCuts (STGraph &ST, list<node_pair> &st_list);
+/**
+ * @fn CactusMinCuts (STGraph &ST, int cG)
+ * @brief find and delete all edges in at least one minimum weight cut set
+ *
+ * @param ST the graph @f$S_T /E_T^{\max }@f$
+ * @param cG the minimum-weight cut of @f$S_T /E_T^{\max }@f$
+ *
+ * Does the same job as AllMinCuts, but finds the edges using the classes
+ * of vertices that map to the same node in the cactus of all minimum cuts
+ * (see CactusMinCutArcs), rather than a flow for every (s,t) pair.
+ */
+void CactusMinCuts (STGraph &ST, int cG);
 /**
  * @fn MakeClusterGraph 
  * @brief Make cluster graph for input trees
@@ -275,14 +368,26 @@ void AllMinCuts (STGraph &ST, list<node_pair> &st_list);
  * of taxa shared by the two nodes is greater than or equal to the
  * threshold k. The default value of k=2 is the minimum necessary to build
  * a supertree. If the cluster graph is not connected we find and output
- * the components.
+ * the components. The pairs of trees that share at least k taxa are found
+ * by FindSharedTaxa.
  *
  */
 void MakeClusterGraph (NTreeVector &T, int k = 2);
+/**
+ * @fn GetTreeTaxa
+ * @brief The label numbers of the leaves of each tree, in increasing order
+ *
+ * @return the largest label number
+ */
+int GetTreeTaxa (NTreeVector &T, vector< vector<int> > &taxa);
 /**
  * @fn MakeCOGraph 
  * @brief Make graph of co-occurrences of all leaves
  *
+ * Gives CO the taxa of each tree. CO only counts co-occurrences if
+ * CollapseGraph asks for them. The graph itself is only built if it is
+ * to be written to a GML or dot file.
+ *
  */
 void MakeCOGraph (NTreeVector &T, Profile<NTree> &p);
 /**
@@ -291,10 +396,20 @@ void MakeCOGraph (NTreeVector &T, Profile<NTree> &p);
  *
  * The binary encoded trees are written to a transposed matrix
  * in the same style as Joe Thorley's RadCon program. This gretaly
- * simplifies writing the matrix.
+ * simplifies writing the matrix. The trees must have their leaf label
+ * numbers set. The rows are written by WriteMRPMatrix.
+ *
+ */
+void WriteMRP (ostream &f, const vector<FlatTree> &T, Profile<NTree> &p);
+/**
+ * @fn WriteProfileCache
+ * @brief Write the input trees and their labels to a profile cache
+ *
+ * The cache can be given instead of the tree file in later runs, and is
+ * read much faster.
  *
  */
-void WriteMRP (ostream &f, NTreeVector &T, Profile<NTree> &p);
+void WriteProfileCache (const char *filename, NTreeVector &T, Profile<NTree> &p);
 
 /*
 The idea that Semple and Steel only collapse edges that are unanimously supported.
@@ -310,7 +425,7 @@ the input set of trees.
 
 
 */
-void CollapseGraph (STGraph &ST, STGraph &fan);
+void CollapseGraph (STGraph &ST, const FanPairs &fan, STree &tree);
 
 
 #define TEST_1				1
@@ -325,9 +440,15 @@ void CollapseGraph (STGraph &ST, STGraph &fan);
 #define USE_CLIQUE			0
 #define USE_OTHER			1
 
+// Number of contradicted edges in each task when the edges adjacent to
+// them are coloured in parallel
+#define COLOUR_TASK_SIZE	256
+
 //------------------------------------------------------------------------------
-void CollapseGraph (STGraph &ST, STGraph &fan)
+void CollapseGraph (STGraph &ST, const FanPairs &fan, STree &tree)
 {
+	CO.Build ();
+
 	graph::edge_iterator cit = ST.edges_begin();
 	graph::edge_iterator cend = ST.edges_end();
 	int num_contradicted_edges = 0;
@@ -340,8 +461,8 @@ void CollapseGraph (STGraph &ST, STGraph &fan)
 		node n2 = cit->target ();
 
 		int freq_nested = ST.f[*cit];
-		int freq_co = CO.GetEdgeFreqFromNodeLabels (ST.node_labels[n1], ST.node_labels[n2]);
-		int freq_fan = fan.GetEdgeFreqFromNodeLabels (ST.node_labels[n1], ST.node_labels[n2]);
+		int freq_co = CO.GetFreq (ST.node_ids[n1], ST.node_ids[n2]);
+		int freq_fan = fan.GetFreq (ST.node_ids[n1], ST.node_ids[n2]);
 		
 		int conflict = freq_co - freq_nested - freq_fan;
 
@@ -364,66 +485,56 @@ void CollapseGraph (STGraph &ST, STGraph &fan)
 #if TEST_1
 	// Edges that are adjacent to a contradicted edge should not
 	// be merged into a component as they are conflicts that need to be
-	// cut later. We colour these edges "colour_adjto_contradicted"
+	// cut later. For each contradicted edge (s,t) we find the nodes u
+	// adjacent to both s and t by edges that are not contradicted, and colour
+	// the edges (s,u) and (t,u) "colour_adjto_contradicted". As only edges
+	// that are not contradicted change colour, the contradicted edges can be
+	// done in any order, and in parallel.
+	NeighbourSets neighbours;
+	neighbours.Build (ST, ST.edge_colour, colour_contradicted);
+	vector< std::pair<int, int> > contradicted;
 	cit = ST.edges_begin();
 	while (cit != cend)
 	{
-		node s = cit->source ();
-		node t= cit->target ();
-		
 		if (ST.edge_colour[*cit] == colour_contradicted)
+			contradicted.push_back (std::pair<int, int> (neighbours.GetIndex (cit->source()),
+				neighbours.GetIndex (cit->target())));
+		cit++;
+	}
+	vector< std::atomic<bool> > adjto_contradicted (neighbours.GetNumEdges());
+	for (int k = 0; k < neighbours.GetNumEdges(); k++)
+		adjto_contradicted[k].store (false, std::memory_order_relaxed);
+
+	auto colour_edges = [&neighbours, &contradicted, &adjto_contradicted] (size_t first, size_t last)
+	{
+		vector<int> es, et;
+		for (size_t i = first; i < last; i++)
 		{
-		
-//			cout << "contradicted edge " << (*cit) << endl;
-			NodeSet c;
-		
-		
-			// List all nodes adjacent to s that are not linked
-			// by a contradicted edge
-			NodeSet adjacent_to_s;
-			node::adj_edges_iterator nit = s.adj_edges_begin();
-			node::adj_edges_iterator nend = s.adj_edges_end();
-			while (nit != nend)
+			neighbours.GetCommonNeighbours (contradicted[i].first, contradicted[i].second, es, et);
+			for (size_t k = 0; k < es.size(); k++)
 			{
-				if (ST.edge_colour[*nit] != colour_contradicted)
-					adjacent_to_s.insert (s.opposite (*nit));
-				nit++;
-			}	
-			// List all nodes adjacent to t that are not linked
-			// by a contradicted edge
-			nit = t.adj_edges_begin();
-			nend = t.adj_edges_end();
-			while (nit != nend)
-			{
-				if (ST.edge_colour[*nit] != colour_contradicted)
-				{
-					NodeSet::iterator n = adjacent_to_s.find (t.opposite (*nit));
-					if (n != adjacent_to_s.end())
-					{
-						c.insert (*n);
-						ST.edge_colour[*nit] = colour_adjto_contradicted;
-//						cout << " adj: " << (*nit) << endl;
-					}
-				}
-				nit++;
-			}	
-			nit = s.adj_edges_begin();
-			nend = s.adj_edges_end();
-			while (nit != nend)
-			{
-				NodeSet::iterator n = c.find (s.opposite (*nit));
-				if (n != c.end())
-				{
-					ST.edge_colour[*nit] = colour_adjto_contradicted;
-//					cout << " adj: " << (*nit) << endl;
-				}
-				nit++;
-			}	
-			
-						
+				adjto_contradicted[es[k]].store (true, std::memory_order_relaxed);
+				adjto_contradicted[et[k]].store (true, std::memory_order_relaxed);
+			}
 		}
-		
-		cit++;
+	};
+	if ((pool != NULL) && (contradicted.size() >= COLOUR_TASK_SIZE))
+	{
+		TaskGroup group;
+		for (size_t first = 0; first < contradicted.size(); first += COLOUR_TASK_SIZE)
+		{
+			size_t last = min (first + COLOUR_TASK_SIZE, contradicted.size());
+			pool->Submit (group, [&colour_edges, first, last] { colour_edges (first, last); });
+		}
+		pool->Wait (group);
+	}
+	else
+		colour_edges (0, contradicted.size());
+
+	for (int k = 0; k < neighbours.GetNumEdges(); k++)
+	{
+		if (adjto_contradicted[k].load (std::memory_order_relaxed))
+			ST.edge_colour[neighbours.GetEdge (k)] = colour_adjto_contradicted;
 	}
 	
 #if SHOW_COLOURS
@@ -459,10 +570,12 @@ void CollapseGraph (STGraph &ST, STGraph &fan)
 			cit++;
 	}
 	
-	if (!ST.is_connected())
+	STComponents cp;
+	cp.Find (ST);
+	if (cp.GetNumComponents() > 1)
 	{
 		// We can cut only contradicted edges
-		superTree.GetCurNode()->AppendLabel("h");
+		tree.GetCurNode()->AppendLabel("h");
 	}
 	else
 	{
@@ -480,100 +593,68 @@ void CollapseGraph (STGraph &ST, STGraph &fan)
 			else
 				cit++;
 		}
+		cp.Find (ST);
 	}
 	
-	if (!ST.is_connected())
+	if (cp.GetNumComponents() > 1)
 	{
 		// 2. Get components
-	    components cp;
-	    if (cp.check(ST) != algorithm::GTL_OK) 
+//		cout << "Graph has " << cp.GetNumComponents() << " components" << endl;
+
+		// 3. Restore hidden edges
+		list<edge>::iterator lit = hidden_edges.begin();
+		list<edge>::iterator lend = hidden_edges.end();
+		while (lit != lend)
 		{
-			cerr << "component check failed at line " << __LINE__ << endl;
-			exit(1);
-	    } 
-		else 
+			ST.restore_edge (*lit);
+			lit++;
+		}
+		
+		// 4. List components and merge member nodes. The first node of
+		// each component is the one the depth first search started from
+		for (int c = 0; c < cp.GetNumComponents(); c++)
 		{
-			if (cp.run(ST) != algorithm::GTL_OK) 
-			{
-		    	cerr << "component algorithm failed at line " << __LINE__ << endl;
-				exit(1);
-			} 
-			else 
+			node first = cp.nodes[cp.offset[c]];
+			for (int k = cp.offset[c]; k < cp.offset[c + 1]; k++)
 			{
-//				cout << "Graph has " << cp.number_of_components() << " components" << endl;
-
-				// 3. Restore hidden edges
-				list<edge>::iterator lit = hidden_edges.begin();
-				list<edge>::iterator lend = hidden_edges.end();
-				while (lit != lend)
-				{
-					ST.restore_edge (*lit);
-					lit++;
-				}
-				
-				// 4. List components and merge member nodes
-				components::component_iterator it = cp.components_begin ();
-				components::component_iterator end = cp.components_end ();
-				list <node> acomponent;
-				while (it != end)
+			#if SHOW_COMPONENTS
+				std::copy (ST.ns[cp.nodes[k]].begin(), ST.ns[cp.nodes[k]].end(),
+					std::ostream_iterator<node>(cout, " "));
+			#endif		
+								
+				if (k != cp.offset[c])
 				{
-					acomponent = (*it).first;
-					list<node>::iterator anode = acomponent.begin();
-					list<node>::iterator first = anode;					
-					list<node>::iterator last_node = acomponent.end();
-					set<std::string> vertices;
-					while (anode != last_node)
-					{
-					
-					#if SHOW_COMPONENTS
-						std::copy (ST.ns[*anode].begin(), ST.ns[*anode].end(),
-							std::ostream_iterator<node>(cout, " "));
-					#endif		
-										
-						if (anode != first)
-						{
-							ST.mergeNodes (*first, *anode); 
-						}							
-										
-						anode++;
-					}
-					
-					// Hide the merged nodes
-					
-					// There was a subtle bug here for novice STL programmers like me.
-					// I want to hide all nodes except *first. To do this I iterate over
-					// the list of nodes in *first's node set and hide them, except for
-					// *first itself. Originally I did this by skipping the first element
-					// in the node set like this
-					//
-					//    sit++;
-					//    while (sit != send)
-					//
-					// This assumes that the first element in the set is always the first added
-					// and this need not be the case. New code starts from the begining of the set
-					// and explicitly tests whether the current element is the node *first.
-
-					NodeSet::iterator sit = ST.ns[*first].begin();
-					NodeSet::iterator send = ST.ns[*first].end();
-					while (sit != send)
-					{
-						if ((*sit) != (*first))
-							ST.hide_node(*sit);
-						sit++;
-					}
-					
-					
-					
-		
-					
-					
-					#if SHOW_COMPONENTS
-					cout << endl;
-					#endif
-					
-					it++;
-				}
+					ST.mergeNodes (first, cp.nodes[k]); 
+				}							
 			}
+			
+			// Hide the merged nodes
+			
+			// There was a subtle bug here for novice STL programmers like me.
+			// I want to hide all nodes except first. To do this I iterate over
+			// the list of nodes in first's node set and hide them, except for
+			// first itself. Originally I did this by skipping the first element
+			// in the node set like this
+			//
+			//    sit++;
+			//    while (sit != send)
+			//
+			// This assumes that the first element in the set is always the first added
+			// and this need not be the case. New code starts from the begining of the set
+			// and explicitly tests whether the current element is the node first.
+
+			NodeSet::iterator sit = ST.ns[first].begin();
+			NodeSet::iterator send = ST.ns[first].end();
+			while (sit != send)
+			{
+				if ((*sit) != first)
+					ST.hide_node(*sit);
+				sit++;
+			}
+			
+			#if SHOW_COMPONENTS
+			cout << endl;
+			#endif
 		}
 		
 #if SHOW_BROKEN
@@ -810,79 +891,91 @@ void CollapseGraph (STGraph &ST, STGraph &fan)
 
 
 //------------------------------------------------------------------------------
-void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p)
+void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step)
 {
 	// Step 1: Simple Semple and Steel
 	//
 	// Any nodes connected by an edge e for which w(e) = wsum are
 	// merged.
 	
-	// 1. Get list of all edges w(e) == wsum
-	list <edge> edges;
-	
+	// 1. Find the classes of nodes joined by edges with w(e) == wsum. Within
+	// a class every pair of nodes is joined by such an edge, and the class is
+	// represented by the source of the first of its edges.
+	int num_ids = ST.GetNumIds ();
+	UnionFind classes (num_ids);
+	vector<int> sources;
 	graph::edge_iterator eit = ST.edges_begin();
 	graph::edge_iterator eend = ST.edges_end ();
 	while (eit != eend)
 	{
 		if (ST.w0[*eit] == wsum)
 		{
-			edges.push_back (*eit);
+			int s = ST.node_ids[eit->source()];
+			classes.Union (s, ST.node_ids[eit->target()]);
+			sources.push_back (s);
 		}										
 		eit++;
 	}
 
-
-	// 2. Collapse these edges	
-	while (edges.size() != 0)
+	// 2. Collapse the classes. Any edge (t,v) from a node t that is merged
+	// with s has the same weight as the edge (s,v), so we delete the edges
+	// of t and keep those of s. Node t is then an element of s's node set.
+	// Hide this node so the graph object ignores t
+	if (sources.size() != 0)
 	{
-		edge e = edges.front();
-		
-		// Merge nodes s and t where lit=e(s,t)
-		node s = e.source();
-		node t = e.target();
-		ST.ns[s].insert (t);
-			
-		node::adj_edges_iterator it;
-		node::adj_edges_iterator end;
-   		it = t.adj_edges_begin();
-    	end = t.adj_edges_end();
-    	
-    	list<edge> to_be_deleted;
-    	// When w(e) == sum, any edge adjacent to t is also adjacent to s,
-    	// so we delete that edge
-		while (it != end)
+		vector<int> representative (num_ids, -1);
+		for (int i = 0; i < sources.size(); i++)
 		{
-			node v = t.opposite (*it);
-			
-			if (v != s)
-			{
-				// If this edge has w(e) == wsum then delete from list of 
-				// edges to be considered
-				if (ST.w0[*it] == wsum)
-					edges.remove (*it);
-					
-				to_be_deleted.push_back (*it);								
-										
-			}
-			it++;
+			int c = classes.Find (sources[i]);
+			if (representative[c] == -1)
+				representative[c] = sources[i];
 		}
-		
-		// Delete the extra edges
-		list<edge>::iterator lit = to_be_deleted.begin();
-		list<edge>::iterator lend = to_be_deleted.end();
-		while (lit != lend)
+
+		// List the members of the classes, grouped by class and in order
+		// of taxon id, so that only the merged nodes and their edges are visited.
+		// The members of class c are members[offset[c]] ... members[offset[c+1]-1]
+		vector<int> offset (num_ids + 1, 0);
+		for (int t = 0; t < num_ids; t++)
 		{
-			ST.del_edge (*lit);
-			lit++;
+			if (representative[classes.Find (t)] != -1)
+				offset[classes.Find (t) + 1]++;
+		}
+		for (int c = 0; c < num_ids; c++)
+			offset[c + 1] += offset[c];
+		vector<int> members (offset[num_ids]);
+		vector<int> pos (offset.begin(), offset.end() - 1);
+		for (int t = 0; t < num_ids; t++)
+		{
+			int c = classes.Find (t);
+			if (representative[c] != -1)
+				members[pos[c]++] = t;
+		}
+
+		vector<edge> to_be_deleted;
+		for (int c = 0; c < num_ids; c++)
+		{
+			if (offset[c + 1] - offset[c] < 2)
+				continue;
+			node s = ST.GetIdNode (representative[c]);
+			for (int k = offset[c]; k < offset[c + 1]; k++)
+			{
+				if (members[k] == representative[c])
+					continue;
+				node t = ST.GetIdNode (members[k]);
+				to_be_deleted.clear ();
+				node::adj_edges_iterator ait = t.adj_edges_begin();
+				node::adj_edges_iterator aend = t.adj_edges_end();
+				while (ait != aend)
+				{
+					to_be_deleted.push_back (*ait);
+					ait++;
+				}
+				for (int i = 0; i < to_be_deleted.size(); i++)
+					ST.del_edge (to_be_deleted[i]);
+				ST.ns[s].insert (t);
+				ST.hide_node (t);
+			}
 		}
-		
-		edges.pop_front();
-		
-		// Delete the edge e(s,t)
-		ST.del_edge (e);
-		// Node t is now merged with s (i.e., is an element of s's node set).
-		// Hide this node so the graph object ignores t
-		ST.hide_node (t);				
 	}
 	
 
@@ -891,57 +984,68 @@ void MakeSTEmax (STGraph &ST, int wsum, NTreeVector &T, Profile<NTree> &p)
 	if (use_algorithm == ALGORITHM_ROD1)
 	{
 	
-		// fans
-		STGraph fan;
-		fan.make_undirected();
-		
+		// fans. The clusters of the trees were built by MinCutSupertree
+		vector< vector<const ClusterSet *> > fans;
 		for (int i = 0; i < T.size(); i++)
 		{
 			NNodePtr root = (NNodePtr)T[i].GetRoot();
 			if (root->GetDegree() > 2)
 			{
+				fans.push_back (vector<const ClusterSet *>());
+				NNodePtr n = (NNodePtr)root->GetChild();
+				while (n)
+				{
+					fans.back().push_back (&n->Cluster);
+					n = (NNodePtr)n->GetSibling();
+				}
+
 				if (bShowFan)
+				{
 					cout << "fan" << endl;
-			
-    			T[i].BuildLabelClusters ();
-				T[i].Update();
-				if (bShowFan)
 					T[i].Draw (cout);
-	
-				NNodePtr n1 = (NNodePtr)root->GetChild();	
-				while (n1->GetSibling())
-				{
-					NNodePtr n2 = (NNodePtr)n1->GetSibling();
-					while (n2)
-					{
-						IntegerSet::iterator n1it = n1->Cluster.begin();
-						IntegerSet::iterator n1end = n1->Cluster.end();
-						while (n1it != n1end)
-						{					
-							IntegerSet::iterator n2it = n2->Cluster.begin();
-							IntegerSet::iterator n2end = n2->Cluster.end();
-							while (n2it != n2end)
-							{
-								if (bShowFan)
+					vector<const ClusterSet *> &fan = fans.back();
+					for (int c1 = 0; c1 < fan.size(); c1++)
+						for (int c2 = c1 + 1; c2 < fan.size(); c2++)
+							for (ClusterSet::iterator n1it = fan[c1]->begin(); n1it != fan[c1]->end(); n1it++)
+								for (ClusterSet::iterator n2it = fan[c2]->begin(); n2it != fan[c2]->end(); n2it++)
 									cout << (*n1it) << "-" << (*n2it) << endl;
-								fan.AddEdge (p.GetLabelFromIndex ((*n1it)-1), p.GetLabelFromIndex ((*n2it)-1));
-								n2it++;
-							}
-							n1it++;
-						}
-						n2 = (NNodePtr)n2->GetSibling();
-					}
-					n1 = (NNodePtr)n1->GetSibling();
 				}
 			}
 		}
-		{	
-			char buf[256];
-			sprintf (buf, "colours%d.gml", (graph_count-1));
-			fan.save (buf);
-		}	
+		FanPairs fan;
+		fan.Build (fans);
 
-		CollapseGraph (ST, fan);
+		if (bSaveSTEmax)
+		{
+			// The graph of the fans is only needed for the GML file
+			STGraph fan_graph;
+			fan_graph.make_undirected();
+			fan_graph.SetLabels (&p.GetLabels());
+			for (int i = 0; i < fans.size(); i++)
+			{
+				vector<const ClusterSet *> &fan = fans[i];
+				for (int c1 = 0; c1 < fan.size(); c1++)
+					for (int c2 = c1 + 1; c2 < fan.size(); c2++)
+						for (ClusterSet::iterator n1it = fan[c1]->begin(); n1it != fan[c1]->end(); n1it++)
+							for (ClusterSet::iterator n2it = fan[c2]->begin(); n2it != fan[c2]->end(); n2it++)
+								fan_graph.AddEdge ((*n1it)-1, (*n2it)-1);
+			}
+			if (step == NULL)
+			{	
+				char buf[256];
+				sprintf (buf, "colours%d.gml", (graph_count-1));
+				fan_graph.save (buf);
+			}	
+			else
+			{
+				// We don't know our step number yet, ReportSteps writes the file
+				ostringstream gml;
+				fan_graph.save (&gml);
+				step->fan_gml = gml.str();
+			}
+		}
+
+		CollapseGraph (ST, fan, tree);
 	}
 	
 
@@ -1045,9 +1149,54 @@ void MinCutEdges (STGraph &ST, int cG)
 
 bool bShowstlist = false;
 bool bShowFlow = false;
-bool bShowResiduals = false;
 bool bShowStrong = false;
 
+void DeleteMinCutEdges (STGraph &ST, CSRGraph &G, vector<char> &in_a_min_cut_set);
+
+typedef pair<csr_index, csr_index> st_pair;
+
+//------------------------------------------------------------------------------
+// Set in_a_min_cut_set[a] for each arc a of G that is in a minimum s-t cut,
+// for the pairs first,...,last-1 in pairs
+void MarkMinCutArcs (const CSRGraph &G, const vector<st_pair> &pairs, size_t first, size_t last,
+	vector<char> &in_a_min_cut_set)
+{
+	DinicFlow flow (G);
+	vector<int> cp;
+	in_a_min_cut_set.resize (G.GetNumArcs(), 0);
+	
+	for (size_t i = first; i < last; i++)
+	{
+		// Find maximum (s,t) flow
+		int max_flow = flow.Run (pairs[i].first, pairs[i].second);
+		if (bShowFlow)
+			cout << "max flow = " << max_flow << endl;
+				
+		// get strong components of the residual graph
+		int scc = flow.ResidualComponents (cp);
+		if (bShowStrong)	
+			cout << "   graph has " << scc << " strong components" << endl;
+
+		// Edges in mincut
+		// Corollary 6 of Picard and Queryanne states that an edge
+		// is in a mincut iff its ends do not lie in the same
+		// strongly connected component. An edge with no capacity left in
+		// one direction has some left in the other, so it is always in the
+		// residual graph.
+		for (csr_index u = 0; u < G.GetNumVertices(); u++)
+		{
+			for (csr_index a = G.offset[u]; a < G.offset[u + 1]; a++)
+			{
+				if (cp[u] != cp[G.arcs[a].target] && flow.IsResidual (a))
+				{
+					in_a_min_cut_set[a] = 1;
+					in_a_min_cut_set[G.twin[a]] = 1;
+				}
+			}
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 void AllMinCuts (STGraph &ST, list<node_pair> &st_list)
 {
@@ -1070,223 +1219,146 @@ void AllMinCuts (STGraph &ST, list<node_pair> &st_list)
 	// 1. For each (s,t) pair compute the maximum flow
 	// 2. Get the strong components of the residual graph for the flow
 	// 3. Identify the edges in the cut(s)
+	//
+	// The flows are computed on a compact copy of ST, so ST itself is not
+	// changed until we delete the edges in the cuts.
+	CSRGraph G;
+	G.Build (ST, ST.w0);
 
-
-	// Boolean flag to indicate if an edge is in a cut
-	edge_map <bool> in_a_min_cut_set (ST, false);
+	vector<st_pair> pairs;
+	st = st_list.begin();
+	while (st != st_list.end())
+	{
+		pairs.push_back (st_pair (G.GetIndex ((*st).first), G.GetIndex ((*st).second)));
+		st++;
+	}
 	
-	// Map between edges and original edges in graph
-	edge_map <edge> orig;
+	// Flag to indicate if an arc is in a cut
+	vector<char> in_a_min_cut_set (G.GetNumArcs(), 0);
 
-	// To compute a flow we need a directed graph, so we need to convert our undirected
-	// graph into a directed graph by "splitting" the undirected edges into a pair
-	// of directed edges pointing in opposite directions.
-	ST.make_directed();
-	edge_map<double> capacity;
+	if ((pool != NULL) && (pairs.size() > 1))
+	{
+		// The pairs are independent, so we share them out between tasks. Each
+		// task has its own flow and flags, and we combine the flags at the end.
+		int num_tasks = min ((int)pairs.size(), 4 * pool->GetNumThreads());
+		vector< vector<char> > task_flags (num_tasks);
+		TaskGroup group;
+		for (int i = 0; i < num_tasks; i++)
+		{
+			size_t first = (pairs.size() * i) / num_tasks;
+			size_t last = (pairs.size() * (i + 1)) / num_tasks;
+			vector<char> *flags = &task_flags[i];
+			pool->Submit (group, [&G, &pairs, first, last, flags]
+				{ MarkMinCutArcs (G, pairs, first, last, *flags); });
+		}
+		pool->Wait (group);
+		
+		for (int i = 0; i < num_tasks; i++)
+		{
+			for (csr_index a = 0; a < G.GetNumArcs(); a++)
+				in_a_min_cut_set[a] |= task_flags[i][a];
+		}
+	}
+	else
+		MarkMinCutArcs (G, pairs, 0, pairs.size(), in_a_min_cut_set);
 
-	// Store list of original edges in the graph
+	DeleteMinCutEdges (ST, G, in_a_min_cut_set);
+}
+
+//------------------------------------------------------------------------------
+void CactusMinCuts (STGraph &ST, int cG)
+{
+	CSRGraph G;
+	G.Build (ST, ST.w0);
+	vector<char> in_a_min_cut_set;
+	CactusMinCutArcs (G, cG, in_a_min_cut_set);
+	DeleteMinCutEdges (ST, G, in_a_min_cut_set);
+}
+
+//------------------------------------------------------------------------------
+// Delete the edges of ST whose arcs in G (a CSRGraph copy of ST) are in a cut.
+// We hide every edge and then restore those not in a cut set, so that the edges
+// of ST (and of each node) stay in the same order as when the flows were done
+// with GTL.
+void DeleteMinCutEdges (STGraph &ST, CSRGraph &G, vector<char> &in_a_min_cut_set)
+{
 	list<edge> l;
 	edge e;
 	forall_edges (e, ST)
 	{
 		l.push_back (e);
-		orig[e] = e;
 	}
-	
-	// Go through each edge and create a reversed copy
 	list<edge>::iterator it = l.begin();
 	while (it != l.end())
 	{
-		node source = it->source();
-		node target = it->target();
-		edge e = ST.new_edge (target, source); // reverse direction to *it
-		ST.w0[e] = ST.w0[*it];
-		
-		orig[e] = *it;
-
-		// Set edge capacity to the weight of the edge
-		capacity[*it] = (double)ST.w0[e];
-		capacity[e] = capacity[*it];
-		
+		ST.hide_edge (*it);
 		it++;
 	}
-
-	//ST.save ("double.gml");
-		
-			
-	// Iterate over each (s,t) pair 
-	int st_count = 0;		
-	st = st_list.begin();
-	while (st != st_list.end())
+	it = l.begin();
+	while (it != l.end())
 	{
-//		cout << (*st).first << "," << (*st).second << endl;
-		
-		// Find maximum (s,t) flow
-		maxflow_ff ff;
-	
-		ff.set_vars (capacity, (*st).first, (*st).second);
-		
-	    if (ff.check(ST) != algorithm::GTL_OK) 
-		{
-			cerr << "maxflow_ff check failed" << endl;
-			exit(1);
-	    } 
-		else 
-		{
-			if (ff.run(ST) != algorithm::GTL_OK) 
-			{
-		    	cerr << "maxflow_ff algorithm failed" << endl;
-				exit(1);
-			} 
-			else 
-			{
-				if (bShowFlow)
-					cout << "max flow = " << ff.get_max_flow() << endl;
-				
-				// ff.run restores the graph (sigh), which means the hidden nodes reappear.
-				// Since some hidden nodes are merged nodes, I don't want these to 
-				// be visible as they are unconnected and hence bugger the next iteration
-				// of maximum flow
-				{
-					graph::node_iterator n_it, n_end, n_tmp;
-
-					n_it = ST.nodes_begin();
-					n_end = ST.nodes_end();
-
-					while (n_it != n_end) 
-					{
-						n_tmp = n_it;
-						++n_tmp;
-						if (n_it->degree() == 0)
-							ST.hide_node(*n_it);
-						n_it = n_tmp;
-					}
-				}
-				
-				
-				if (bShowFlow)
-				{
-					char buf[64];
-					sprintf (buf, "flow_%d.gml", st_count);
-					ST.save (buf);	
-					st_count++;
-				}
-				
-	
-				// Residual capacities.
-				// Hide any edge with a non positive residual capacity
-	
-				if (bShowFlow)
-					cout << "   find residual flows..." << endl;
-					
-				edge e;
-				list<edge> to_hide;
-				forall_edges (e, ST)
-				{
-					if (ff.get_rem_cap (e) <= 0.0)
-						to_hide.push_back(e);
-				}
-				list<edge>::iterator it = to_hide.begin();
-				while (it != to_hide.end())
-				{
-					ST.hide_edge (*it);
-					it++;
-				}
-				
-				if (bShowResiduals)
-				{
-					char buf[64];
-					sprintf (buf, "residual_%d.gml", st_count);
-					ST.save (buf);	
-					st_count++;
-				}
-							
-				// get strong components
-				node_map<int> cp(ST,-1);
-				int scc = STRONG_COMPONENTS (ST, cp);
-				
-				if (bShowStrong)	
-					cout << "   graph has " << scc << " strong components" << endl;
-				
-				/*{
-					node n;
-					forall_nodes (n, G0)
-						cout << n << cp[n] << endl;
-				}*/
-					
-				// Edges in mincut
-				// Corollary 6 of Picard and Queryanne states that an edge
-				// is in a mincut iff its ends do not lie in the same
-				// strongly connected component
-				if (bShowStrong)
-					cout << "Identify edges in a cut" << endl;
-				forall_edges (e, ST)
-				{
-					if (cp[e.source()] != cp[e.target()])
-					{
-						in_a_min_cut_set[orig[e]] = true;
-						if (bShowStrong)
-							cout << e << "is in a mincut" << endl;
-					}
-				}
-				
-				
-				// Restore hidden edges
-				it = to_hide.begin();
-				while (it != to_hide.end())
-				{
-					ST.restore_edge (*it);
-					it++;
-				}
-				
-			}
-		}
-		
-		
-		st++;
+		csr_index a = G.GetArc (*it);
+		bool in_cut = (a != NO_ARC) && in_a_min_cut_set[a] && (ST.w0[*it] > 0);
+		if (bShowStrong && in_cut)
+			cout << (*it) << "is in a mincut" << endl;
+		if (!in_cut)
+			ST.restore_edge (*it);
+		it++;
 	}
-	
+}
+
 
-	// Restore original undirected graph
+//------------------------------------------------------------------------------
+// Get the labels of the leaves in a component of ST from their taxon ids
+void GetVertexSet (Profile<NTree> &p, vector<int> &ids, set<std::string> &vertices)
+{
+	for (int i = 0; i < ids.size(); i++)
+		vertices.insert (p.GetLabelFromIndex (ids[i]));
+}
 
-	// 1. Hide all the edges
+//------------------------------------------------------------------------------
+// Construct the vector of trees T|S, i.e. the subtree of T that contains
+// only leaves in S (the taxa with ids in ids)
+void RestrictTrees (TreeRestriction &restriction, vector<int> &ids, NTreeVector &TS)
+{
+	restriction.Restrict (ids, TS);
+	if (bShowTS)
 	{
-		edge e;
-		list<edge> to_hide;
-		forall_edges (e, ST)
-		{
-			to_hide.push_back(e);
-		}
-		list<edge>::iterator it = to_hide.begin();
-		while (it != to_hide.end())
+		for (int i = 0; i < TS.size(); i++)
 		{
-			ST.hide_edge (*it);
-			it++;
+			cout << " leaves = " << TS[i].GetNumLeaves() << endl;
+			TS[i].Draw (cout);
 		}
 	}
-	
-	// Restore only those original edges not in a cut set
-	it = l.begin();
-	while (it != l.end())
-	{
-		
-		if (!in_a_min_cut_set [*it])
-		{
-			ST.restore_edge (*it);
-		}	
-		it++;
-	}
-	ST.make_undirected();
 }
 
+//------------------------------------------------------------------------------
+// Output the line in the table of steps for one call to MinCutSupertree
+void ShowInfo (Info &info)
+{
+	cout  << setiosflags (ios::right)
+		<< setw (8) << info.level 
+		<< setw (8) << info.nodes
+		<< setw (8) << info.trees;
+	if (info.connected)
+		cout << "     yes" << setw (8) << info.cut;
+	else
+		cout << "      no        ";
+	cout << setw (16) << info.components << endl;
+}
+
+void SolveComponentsInParallel (STComponents &cp, TreeRestriction &restriction,
+	Profile<NTree> &p, STree &tree, MinCutStep *step);
 
 //------------------------------------------------------------------------------
-void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
+void MinCutSupertree (NTreeVector &T, Profile<NTree> &p, STree &tree, MinCutStep *step)
 {
 	int wsum = 0;
+	Info info;
 	
 	STGraph ST;
 	ST.make_undirected();
+	ST.SetLabels (&p.GetLabels());
 
 	if (bShowLevel)
 		cout << "-------------- LEVEL " << level << "----------------" << endl;
@@ -1295,6 +1367,9 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 	if (bShowConstruct)
 		cout << "Construct ST" << endl;
 		
+	// Clusters of the children of the root of each tree, and the weight of the tree
+	vector<const ClusterSet *> clusters;
+	vector<int> weights;
 	for (int i = 0; i < T.size(); i++)
 	{
     	T[i].BuildLabelClusters ();
@@ -1317,9 +1392,10 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 		{
 			if (n->IsLeaf())
 			{
-				ST.AddNode (n->GetLabel());
+				clusters.push_back (&n->Cluster);
+				weights.push_back ((int)T[i].GetWeight());
 			}
-			else
+			else if (n->Cluster.size() > 1)
 			{
 				if (bShowSTEdge)
 				{
@@ -1329,30 +1405,33 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 					cout << "}" << endl;*/
 				}
 
-				IntegerSet::iterator iit = n->Cluster.begin();
-				IntegerSet::iterator iend = n->Cluster.end();
-				while (iit != iend)
+				if (bShowSTEdge)
 				{
-					IntegerSet::iterator jit = iit;
-					jit++;
-					while (jit != iend)
+					ClusterSet::iterator iit = n->Cluster.begin();
+					ClusterSet::iterator iend = n->Cluster.end();
+					while (iit != iend)
 					{
-						if (bShowSTEdge)
+						ClusterSet::iterator jit = iit;
+						jit++;
+						while (jit != iend)
 						{
 							cout << p.GetLabelFromIndex ((*iit)-1) << "-" 
 								<< p.GetLabelFromIndex ((*jit)-1) << endl;
+							jit++;
 						}
-						// 5 Nov 2001
-						// Edges are weighted by tree weights
-						ST.AddEdge (p.GetLabelFromIndex ((*iit)-1), p.GetLabelFromIndex ((*jit)-1), (int)T[i].GetWeight());
-						jit++;
+						iit++;
 					}
-					iit++;
 				}
+
+				// 5 Nov 2001
+				// Edges are weighted by tree weights
+				clusters.push_back (&n->Cluster);
+				weights.push_back ((int)T[i].GetWeight());
 			}
 			n = (NNodePtr)n->GetSibling();
 		}
 	}
+	BuildSTGraph (ST, clusters, weights, pool);
 	
 	info.level = graph_count; 
 	info.nodes = ST.number_of_nodes();
@@ -1382,10 +1461,13 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 		}
 		
 	}
-	graph_count++;
+	// In parallel the steps are numbered by ReportSteps once we have finished
+	if (step == NULL)
+		graph_count++;
 
+	// ST keeps a count of its components as the edges are added
 	int minimumCut = 0;
-	if (ST.is_connected())
+	if (ST.GetNumIdComponents() == 1)
 	{
 		// If ST is connected then we construct ST/Emax. This merges nodes that are part of
 		// a clique of nodes with maximally weighted edges. We delete all edges that are in
@@ -1396,7 +1478,7 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 		// 5.
 		if (bShowConnected)
 			cout << "ST is connected so constructing ST/Emax" << endl;
-		MakeSTEmax (ST, wsum, T, p);
+		MakeSTEmax (ST, wsum, T, p, tree, step);
 		
 		list<node_pair> st_list;
 
@@ -1409,7 +1491,10 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 			
 #if 1
 		// All mincuts algorithm
-		AllMinCuts (ST, st_list);
+		if (use_mincut == MINCUT_CACTUS)
+			CactusMinCuts (ST, minimumCut);
+		else
+			AllMinCuts (ST, st_list);
 	
 #else				
 		// Semple and Steel brute force
@@ -1418,7 +1503,7 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 
 		char numbuf[16];
 		sprintf (numbuf, "c%d", minimumCut);
-		superTree.GetCurNode()->AppendLabel (numbuf);	
+		tree.GetCurNode()->AppendLabel (numbuf);	
 
 	}
 	else
@@ -1430,297 +1515,333 @@ void MinCutSupertree (NTreeVector &T, Profile<NTree> &p)
 		if (bShowConnected)
 			cout << "ST is not connected" << endl;
 			
-		superTree.GetCurNode()->AppendLabel ("c0");
+		tree.GetCurNode()->AppendLabel ("c0");
 	}
 
-	// The vertex sets are the components of ST
-    components cp;
-    if (cp.check(ST) != algorithm::GTL_OK) 
+	// The vertex sets are the components of ST. If ST was not connected
+	// the graph has not changed since it was built, and the components are
+	// those ST counted as it was built
+	STComponents cp;
+	if (info.connected)
+		cp.Find (ST);
+	else
+		cp.FindFromIds (ST);
+
+	// Show info -------------------------------------------------------
+	info.components = cp.GetNumComponents();
+	TreeRestriction restriction (T);
+	if (step != NULL)
 	{
-		cerr << "component check failed at " << __LINE__ << " in " << __FILE__  << endl;
-		exit(1);
-    } 
-	else 
+		// Let the tasks solve the components
+		step->info = info;
+		SolveComponentsInParallel (cp, restriction, p, tree, step);
+		return;
+	}
+	ShowInfo (info);
+	
+	// Vist each component ---------------------------------------------
+	if (bShowMinCutWeight)
+		cout  << cp.GetNumComponents() << " components" << endl;
+	if (bShowVertexSets)
+		cout << endl << "ST has " << cp.GetNumComponents() << " vertex sets:" << endl;
+
+	for (int c = 0; c < cp.GetNumComponents(); c++)
 	{
-		if (cp.run(ST) != algorithm::GTL_OK) 
+		set<std::string> vertices;
+		vector<int> ids;
+		cp.GetTaxa (c, ids);
+		if (bShowVertexSets || (ids.size() < 3))
+			GetVertexSet (p, ids, vertices);
+
+		// Handle the vertex set
+		set <std::string>::iterator nsit = vertices.begin();
+		set <std::string>::iterator nsend = vertices.end();
+		
+		if (bShowVertexSets)
 		{
-	    	cerr << "component algorithm failed at " << __LINE__ << " in " << __FILE__ << endl;
-			exit(1);
-		} 
-		else 
+			while (nsit != nsend)
+			{
+				cout << (*nsit) << " ";		
+				nsit++;
+			}
+			cout << endl;
+		}
+		
+		if (ids.size() < 3)
 		{
-			// Show info -------------------------------------------------------
-			info.components = cp.number_of_components();
-			cout  << setiosflags (ios::right)
-				<< setw (8) << info.level 
-				<< setw (8) << info.nodes
-				<< setw (8) << info.trees;
-			if (info.connected)
-				cout << "     yes" << setw (8) << info.cut;
-			else
-				cout << "      no        ";
-			cout << setw (16) << info.components << endl;
+        	// The first component is a child of the current
+            // node in the growing supertree, the other
+            // components are siblings of the first component
+            if (c == 0)
+                tree.MakeChild();
+            else
+                tree.MakeSibling();
+
+			nsit = vertices.begin ();
 			
-			// Vist each component ---------------------------------------------
-			if (bShowMinCutWeight)
-				cout  << cp.number_of_components() << " components" << endl;
-			if (bShowVertexSets)
-				cout << endl << "ST has " << cp.number_of_components() << " vertex sets:" << endl;
-
-			components::component_iterator it = cp.components_begin ();
-			components::component_iterator end = cp.components_end ();
-			list <node> acomponent;
-			while (it != end)
+			if (vertices.size() == 1)
 			{
-				acomponent = (*it).first;
-				list<node>::iterator anode = acomponent.begin();
-				list<node>::iterator last_node = acomponent.end();
-				set<std::string> vertices;
-				while (anode != last_node)
-				{
-//					cout << (*anode);
-//					std::copy (ST.ns[*anode].begin(), ST.ns[*anode].end(),
-//						std::ostream_iterator<node>(cout, " "));
-
-					// Get set of nodes associated with this node in ST
-					NodeSet::iterator nsit = ST.ns[*anode].begin();
-					NodeSet::iterator nsend = ST.ns[*anode].end();
-					while (nsit != nsend)
-					{
-						vertices.insert (ST.node_labels[*nsit]);
-						nsit++;
-					}
-
-					anode++;
-				}
+				// a leaf
+                tree.AddLeaf (*nsit);
+			}
+			else
+			{
+				// a cherry
+                std::string label1 = (*nsit);
+                nsit++;
+                std::string label2 = (*nsit);
+                tree.AddCherry (label1, label2);
+			}
+		}
+		else
+		{
+        	// Component has more than two leaves and hence needs
+            // further analysis
 
-				// Handle the vertex set
-				set <std::string>::iterator nsit = vertices.begin();
-				set <std::string>::iterator nsend = vertices.end();
-				
-				if (bShowVertexSets)
+			// Construct the vector of trees T|S, i.e. the subtree of T that contains
+			// only leaves in S
+			NTreeVector TS;
+			RestrictTrees (restriction, ids, TS);
+			
+			// process T|S ---------------------------------------------
+			if (TS.size () > 0)
+			{
+				if (TS.size() == 1)
 				{
-					while (nsit != nsend)
-					{
-						cout << (*nsit) << " ";		
-						nsit++;
-					}
-					cout << endl;
+					// Here we can use a shortcut. If only a single tree
+                    // has leaves in the current vertex set then we don't need to
+                    // recursively do mincuts, we simply graft the corresponding
+                    // subtree onto the growing supertree.
+					tree.AddSubtree (TS[0], (c == 0));
 				}
-				
-				if (vertices.size() < 3)
-				{
-                	// The first component is a child of the current
+				else
+				{				
+					// More than one tree has leaves in the current vertex set,
+                    // so we find the mincut supertree for the set of subtrees.
+                    // This is where the algorithm becomes recursive.
+					level++;
+					if (bShowRecursion)
+						cout << "--> MinCutSupertree" << endl;
+						
+                    // The first component is a child of the current
                     // node in the growing supertree, the other
                     // components are siblings of the first component
-                    if (it == cp.components_begin ())
-                        superTree.MakeChild();
+                    if (c == 0)
+                        tree.MakeChild();
                     else
-                        superTree.MakeSibling();
+                        tree.MakeSibling();
 
-					nsit = vertices.begin ();
+					tree.PushNode ();
 					
-					if (vertices.size() == 1)
-					{
-						// a leaf
-                        superTree.AddLeaf (*nsit);
-					}
-					else
+					// Output trees for debugging
+					if (bWriteTS)
 					{
-						// a cherry
-                        std::string label1 = (*nsit);
-                        nsit++;
-                        std::string label2 = (*nsit);
-                        superTree.AddCherry (label1, label2);
+						char buf[256];
+						sprintf (buf, "ts-%d.tre", (graph_count - 1));
+						ofstream f (buf);
+						for (int i = 0; i < TS.size(); i++)
+						{
+							NTree t = TS[i];
+							f << t << endl;
+						}
+						f.close();
 					}
+
+					MinCutSupertree (TS, p, tree);
+					if (bShowRecursion)	
+						cout << "<-- MinCutSupertree" << endl;
+						
+                    tree.PopNode();
+
+					level--;	
 				}
-				else
-				{
-                	// Component has more than two leaves and hence needs
-                    // further analysis
+			}		
+		} // if (ids.size() < 3)
+	}
+}
 
-					// Construct the vector of trees T|S, i.e. the subtree of T that contains
-					// only leaves in S
-					NTreeVector TS;
-					for (int i = 0; i < T.size(); i++)
-					{
-						NTree t = T[i];
-						t.BuildLeafLabels ();
-    					t.BuildLabelClusters ();
 
-    					// Get set of leaves in T
-						IntegerSet tset = ((NNodePtr)t.GetRoot())->Cluster;
-						t.Update ();
-						
-    					if (bShowTS)
-    					{
- 							cout << " leaves = " << t.GetNumLeaves() << endl;
-	    					cout << t << endl;
-						/*	std::copy (tset.begin(),tset.end(),
-								std::ostream_iterator<int>(cout, " "));*/
-							cout << endl;
-						}
+/**
+ * @struct ComponentJob
+ * @brief A component of ST that is solved by a task in the thread pool
+ *
+ */
+struct ComponentJob
+{
+	ComponentJob () { step = NULL; };
+	set<std::string> vertices;	// leaves in the component, if fewer than three
+	vector<int> ids;			// taxon ids of the leaves
+	NTreeVector TS;				// T|S
+	STree fragment;				// supertree for T|S, if more than one tree in T|S
+	MinCutStep *step;			// record of the recursive call for T|S (or NULL)
+};
 
+//------------------------------------------------------------------------------
+// The task for a component of ST with three or more leaves
+void SolveComponent (ComponentJob *job, TreeRestriction &restriction, Profile<NTree> &p)
+{
+	RestrictTrees (restriction, job->ids, job->TS);
+	if (job->TS.size() > 1)
+	{
+		// Build the supertree for T|S as a separate tree, which is grafted onto
+		// the supertree once all the components have been done
+		job->step = new MinCutStep;
+		job->fragment.MakeRoot ();
+		job->fragment.PushNode ();
+		job->fragment.SetInternalLabels (true);
+		MinCutSupertree (job->TS, p, job->fragment, job->step);
+		job->fragment.PopNode ();
+		NTreeVector().swap (job->TS);
+	}
+}
 
-						LabelMap::iterator it = p.Labels.begin();
-						LabelMap::iterator end = p.Labels.end();
-						while (it != end)
-						{
-							std::string s = (*it).first;	// label
-							int index = (*it).second;		// 0-offset index of label
-							index++;						// make index 1-offset
-							
-							if (bShowTStest)
-								cout << s << "=" << index;
-							
-							if (tset.find (index) != tset.end())
-							{
-								// label is in original tree
-								if (bShowTStest)
-									cout << " in t";
-								
-								if (vertices.find (s) == vertices.end())
-								{	
-									if (bShowTStest)	
-										cout << " not in v";										
-									// but not in this vertex set	
-									NodePtr q = t.leaf_labels[s];			
-									t.RemoveNode (q);
-									delete q;
-									if (bShowTStest)
-									{
-										cout << " leaves = " << t.GetNumLeaves() << endl;
-										cout << t << endl;
-									}
-
-								}
-							}
-							if (bShowTStest)
-								cout << endl;
-							it++;
-						}
-						
-						if (bShowTStest)
-							cout << " leaves = " << t.GetNumLeaves() << endl;
-						
-						// Only add tree to the list if it has some leaves
-						if (t.GetNumLeaves() > 0)
-						{				
-							t.Update();
-							if (bShowTS)
-								t.Draw (cout);
-						
-							// Build clusters
-    						t.BuildLabelClusters ();
-							TS.push_back (t);
-						}
-					}
-					
-					// process T|S ---------------------------------------------
-					if (TS.size () > 0)
-					{
-						if (TS.size() == 1)
-						{
-							// Here we can use a shortcut. If only a single tree
-                            // has leaves in the current vertex set then we don't need to
-                            // recursively do mincuts, we simply graft the corresponding
-                            // subtree onto the growing supertree.
-							superTree.AddSubtree (TS[0], (it == cp.components_begin ()));
-						}
-						else
-						{				
-							// More than one tree has leaves in the current vertex set,
-                            // so we find the mincut supertree for the set of subtrees.
-                            // This is where the algorithm becomes recursive.
-							level++;
-							if (bShowRecursion)
-								cout << "--> MinCutSupertree" << endl;
-								
-                            // The first component is a child of the current
-                            // node in the growing supertree, the other
-                            // components are siblings of the first component
-                            if (it == cp.components_begin ())
-                                superTree.MakeChild();
-                            else
-                                superTree.MakeSibling();
-
-							superTree.PushNode ();
-							
-							// Output trees for debugging
-							if (bWriteTS)
-							{
-								char buf[256];
-								sprintf (buf, "ts-%d.tre", (graph_count - 1));
-								ofstream f (buf);
-								for (int i = 0; i < TS.size(); i++)
-								{
-									NTree t = TS[i];
-									f << t << endl;
-								}
-								f.close();
-							}
-
-							MinCutSupertree (TS, p);
-							if (bShowRecursion)	
-								cout << "<-- MinCutSupertree" << endl;
-								
-                            superTree.PopNode();
+//------------------------------------------------------------------------------
+// Parallel version of the loop over the components of ST in MinCutSupertree.
+// Each component with three or more leaves is a task, and the results are added
+// to tree in the order of the components, so that the supertree is the same as
+// that built by the serial loop.
+void SolveComponentsInParallel (STComponents &cp, TreeRestriction &restriction,
+	Profile<NTree> &p, STree &tree, MinCutStep *step)
+{
+	vector<ComponentJob> jobs (cp.GetNumComponents());
+	TaskGroup group;
 
-							level--;	
-						}
-					}		
-				} // if (vertices.size() < 3)
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		cp.GetTaxa (i, jobs[i].ids);
+		if (jobs[i].ids.size() >= 3)
+		{
+			ComponentJob *job = &jobs[i];
+			pool->Submit (group, [job, &restriction, &p] { SolveComponent (job, restriction, p); });
+		}
+		else
+			GetVertexSet (p, jobs[i].ids, jobs[i].vertices);
+	}
+	pool->Wait (group);
 
-				it++; // next component
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		ComponentJob &job = jobs[i];
+		
+		// The first component is a child of the current
+		// node in the growing supertree, the other
+		// components are siblings of the first component
+		if (job.ids.size() < 3)
+		{
+			if (i == 0)
+				tree.MakeChild();
+			else
+				tree.MakeSibling();
+
+			set <std::string>::iterator nsit = job.vertices.begin ();
+			if (job.vertices.size() == 1)
+			{
+				// a leaf
+				tree.AddLeaf (*nsit);
+			}
+			else
+			{
+				// a cherry
+				std::string label1 = (*nsit);
+				nsit++;
+				std::string label2 = (*nsit);
+				tree.AddCherry (label1, label2);
 			}
 		}
+		else if (job.step != NULL)
+		{
+			if (i == 0)
+				tree.MakeChild();
+			else
+				tree.MakeSibling();
+			tree.GraftTree (job.fragment);
+			step->children.push_back (job.step);
+		}
+		else if (job.TS.size() == 1)
+		{
+			tree.AddSubtree (job.TS[0], (i == 0));
+		}
 	}
 }
 
+//------------------------------------------------------------------------------
+// Number the steps of a parallel run in the order that the serial recursion
+// makes them, and output what each step would have output.
+void ReportSteps (MinCutStep *step)
+{
+	step->info.level = graph_count++;
+	ShowInfo (step->info);
+	if (step->fan_gml.size() > 0)
+	{
+		char buf[256];
+		sprintf (buf, "colours%d.gml", step->info.level);
+		ofstream f (buf);
+		f << step->fan_gml;
+		f.close ();
+	}
+	for (int i = 0; i < step->children.size(); i++)
+		ReportSteps (step->children[i]);
+}
 
 //------------------------------------------------------------------------------
-void MakeCOGraph (NTreeVector &T, Profile<NTree> &p)
+int GetTreeTaxa (NTreeVector &T, vector< vector<int> > &taxa)
 {
-	CO.make_undirected();
-		
-	// For each tree insert an edge in CO between pairs of taxa that
-	// cooccur in a tree
+	int ntax = 0;
+	taxa.assign (T.size(), vector<int>());
 	for (int i = 0; i < T.size(); i++)
 	{
-   		T[i].BuildLabelClusters ();
-		T[i].Update();		
-		NNodePtr n = (NNodePtr)T[i].GetRoot();
-
-		IntegerSet::iterator iit = n->Cluster.begin();
-		IntegerSet::iterator iend = n->Cluster.end();
-		while (iit != iend)
+		NodeIterator <NNode> n ((NNodePtr)T[i].GetRoot());
+		for (NNodePtr q = n.begin(); q; q = n.next())
 		{
-			IntegerSet::iterator jit = iit;
-			jit++;
-			while (jit != iend)
+			if (q->IsLeaf())
 			{
-				CO.AddEdge (p.GetLabelFromIndex ((*iit)-1), p.GetLabelFromIndex ((*jit)-1));
-				jit++;
+				taxa[i].push_back (q->GetLabelNumber());
+				ntax = max (ntax, q->GetLabelNumber());
 			}
-			iit++;
 		}
+		sort (taxa[i].begin(), taxa[i].end());
+		taxa[i].erase (unique (taxa[i].begin(), taxa[i].end()), taxa[i].end());
 	}
+	return ntax;
+}
+
+//------------------------------------------------------------------------------
+void MakeCOGraph (NTreeVector &T, Profile<NTree> &p)
+{
+	vector< vector<int> > taxa;
+	GetTreeTaxa (T, taxa);
+	CO.SetTaxa (taxa, p.GetNumLabels());
 
+	if (bWriteGML || bWriteDot)
 	{
+		STGraph COGraph;
+		COGraph.make_undirected();
+		COGraph.SetLabels (&p.GetLabels());
+		
+		// For each tree insert an edge in COGraph between pairs of taxa that
+		// cooccur in a tree
+		for (int i = 0; i < taxa.size(); i++)
+		{
+			for (int a = 0; a < taxa[i].size(); a++)
+			{
+				for (int b = a + 1; b < taxa[i].size(); b++)
+					COGraph.AddEdge (taxa[i][a] - 1, taxa[i][b] - 1);
+			}
+		}
+
 		if (bWriteGML)
 		{
-			CO.save ("CO.gml");
+			COGraph.save ("CO.gml");
 			cout << "CO written to CO.gml"  << endl;
 		}
 		if (bWriteDot)
 		{
 			ofstream f ("CO.dot");
-			CO.WriteDotty (f);
+			COGraph.WriteDotty (f);
 			f.close ();
 			cout << "CO written to CO.dot"  << endl;
 		}
 	}
-
 }
 
 //------------------------------------------------------------------------------
@@ -1752,34 +1873,19 @@ void MakeClusterGraph (NTreeVector &T, int k)
 		
 	
 	// Store the leaves in each tree	
-	vector <IntegerSet> leaves;
 	for (int i = 0; i < T.size(); i++)
-	{
-   		T[i].BuildLabelClusters ();
 		T[i].Update();	
-		NNodePtr n = (NNodePtr)T[i].GetRoot();
-		leaves.push_back (n->Cluster);
-	}
-	
-	// Compare all trees and create a edge between corresponding nodes in
-	// ClusterGraph if the number of shared leaves exceeds threshold
-	for (int i = 1; i < T.size(); i++)
+	vector < vector<int> > leaves;
+	int ntax = GetTreeTaxa (T, leaves);
+	
+	// Create an edge between the nodes in ClusterGraph for each pair of
+	// trees where the number of shared leaves exceeds threshold
+	vector<SharedTaxa> pairs;
+	FindSharedTaxa (leaves, ntax, k, pairs);
+	for (int n = 0; n < pairs.size(); n++)
 	{
-
-		for (int j = 0; j < i; j++)
-		{
-			IntegerSet common;
-			std::set_intersection (leaves[i].begin(), leaves[i].end(),
-				leaves[j].begin(), leaves[j].end(),
-				std::inserter (common, common.end()));
-			int w = common.size();
-			if (w >= k)
-			{
-				edge e = ClusterGraph.new_edge (t[i], t[j]);
-				ClusterGraph.w0[e] = w;
-			}
-		
-		}
+		edge e = ClusterGraph.new_edge (t[pairs[n].i], t[pairs[n].j]);
+		ClusterGraph.w0[e] = pairs[n].w;
 	}
 	
 	
@@ -1874,7 +1980,7 @@ void MakeClusterGraph (NTreeVector &T, int k)
 
 //------------------------------------------------------------------------------
 // Use same format as Joe Thorley uses in RadCon
-void WriteMRP (ostream &f, NTreeVector &T, Profile<NTree> &p)
+void WriteMRP (ostream &f, const vector<FlatTree> &T, Profile<NTree> &p)
 {
 	f << "#nexus" << endl << endl;
 	f << "[MRP file written "; 
@@ -1911,7 +2017,7 @@ void WriteMRP (ostream &f, NTreeVector &T, Profile<NTree> &p)
 	for (int i = 0; i < T.size(); i++)
 	{
 		start.push_back (nchar+1);
-		nchar += T[i].GetNumInternals();
+		nchar += T[i].GetNumNodes() - T[i].GetNumLeaves();
 		end.push_back (nchar);
 	}
 
@@ -1921,50 +2027,7 @@ void WriteMRP (ostream &f, NTreeVector &T, Profile<NTree> &p)
 	f << "\tformat symbols=\"01\" missing=? transpose nolabels;" << endl;
 	f << "\tmatrix" << endl;
 		
-	for (int i = 0; i < T.size(); i++)
-	{
-   		T[i].BuildLabelClusters ();
-		T[i].Update();	
-		
-		f << "[" << T[i].GetName() << "]" << endl;
-		
-		// Iterator over nodes in tree
-		NNodePtr r = (NNodePtr)T[i].GetRoot();
-		NodeIterator <NNode> ni (r);
-		NNodePtr n = ni.begin();
-		while (n != NULL)
-		{
-			if (!n->IsLeaf())
-			{
-				// Fill character string with ?
-				std::string s (ntax, '?');
-				
-				// Only leaves in the root cluster will be coded for this tree
-				IntegerSet::iterator iit = r->Cluster.begin();
-				IntegerSet::iterator iend = r->Cluster.end();
-				while (iit != iend)
-				{
-					s[*iit-1] = '0';
-					iit++;
-				}
-
-				// Code any leaf in this cluster as "1", nodes not in this cluster
-				// will be left as "0" 
-				 iit = n->Cluster.begin();
-				 iend = n->Cluster.end();
-				 while (iit != iend)
-				 {
-				 	s[*iit-1] = '1';
-					iit++;
-
-				 }
-				 
-				 f << "0"; // mrp outgroup state is always 0
-				 f << s << endl;
-			}
-			n = ni.next();
-		}
-	}
+	WriteMRPMatrix (f, T, ntax, pool);
 	f << "\t;" << endl;
 	f << "end;" << endl;	
 	f << endl;
@@ -1980,6 +2043,94 @@ void WriteMRP (ostream &f, NTreeVector &T, Profile<NTree> &p)
 
 }
 
+//------------------------------------------------------------------------------
+void WriteProfileCache (const char *filename, NTreeVector &T, Profile<NTree> &p)
+{
+	vector<FlatTree> trees (T.size());
+	for (int i = 0; i < T.size(); i++)
+		trees[i].Assign (T[i]);
+	if (!ProfileCache::Write (filename, p.GetLabels(), trees))
+	{
+		cerr << "Failed to write profile cache \"" << filename << "\"" << endl;
+		exit (0);
+	}
+	cout << "Profile cache written to \"" << filename << "\"" << endl;
+}
+
+/**
+ * @struct TreeFit
+ * @brief The fit of the supertree to one input tree
+ *
+ */
+struct TreeFit
+{
+	QTValues Q;				// triplet counts
+	double fit;				// 1 - (d + r2)/(d + s + r2)
+	double weight;			// weight of the input tree
+	int leaves;				// number of leaves in the input tree
+	std::string name;		// name of the input tree
+};
+
+//------------------------------------------------------------------------------
+// Compare the ith input tree with the subtree induced in the supertree by the
+// leaves of the input tree. This only reads superTree and p, so it can be
+// called for different trees at the same time.
+void ComputeTreeFit (Profile<NTree> &p, int i, TreeFit &result)
+{
+	// Pruning the supertree is destructive so we make a copy of it
+	NTree t1 (superTree);
+	// Get ith input tree
+	NTree t2 = p.GetIthTree (i);
+	
+	t1.MakeNodeList();
+	t2.MakeNodeList();
+	
+	// We need to prune excess leaves from supertree, and ensure that leaves in the pruned
+	// supertree have their LeafNumber field in the range 1...n so the triplet comparison
+	// will work correctly. Note that leaves in t2 are already numbered 1...n
+	IntegerSet toPrune;
+	for (int j = 0; j < t1.GetNumLeaves(); j++)
+	{
+		NodePtr matchingLeaf = t2.GetLeafWithLabel (t1[j]->GetLabel());
+		if (matchingLeaf != NULL)
+		{
+			// This leaf is in t1 AND t2. Set the LeafNumber of this leaf
+			// in t1 to match that in t2
+			t1[j]->SetLeafNumber(matchingLeaf->GetLeafNumber());
+		}
+		else
+		{
+			// This leaf is not in t2 so we will prune it from the supertree
+			toPrune.insert (j);
+		}
+	}
+
+	// Prune excess leaves from t1
+	IntegerSet::iterator nit = toPrune.begin();
+	IntegerSet::iterator nend = toPrune.end();
+	while (nit != nend)
+	{
+		t1.RemoveNode (t1[*nit]);
+		delete t1[*nit];
+		nit++;
+	}
+
+	// Compare flat copies of the two trees. The triplets are counted
+	// without being listed, so this is fast even for large trees
+	FlatTree f1 (t1);
+	FlatTree f2 (t2);
+	
+	QTValues &Q = result.Q;
+	CompareTripletsFast (f1, f2, Q);
+	SummaryStats (Q);
+
+	double different_in_t2 = Q.d + Q.r2;
+	double resolved_in_t2 = Q.d + Q.s + Q.r2;
+	result.fit = 1.0 - different_in_t2/resolved_in_t2;
+	result.weight = t2.GetWeight();
+	result.leaves = t2.GetNumLeaves();
+	result.name = t2.GetName();
+}
 
 //------------------------------------------------------------------------------
 int main (int argc, char **argv)
@@ -2016,6 +2167,8 @@ int main (int argc, char **argv)
 	char nxs_name[FILENAME_SIZE];	
 	char nwk_name[FILENAME_SIZE];
 	char mrp_name[FILENAME_SIZE];
+	char mrpx_name[FILENAME_SIZE];
+	char cache_name[FILENAME_SIZE];
 
 
     while (Getopt(argc, argv, OPTIONS, NOPTIONS, usage,
@@ -2035,6 +2188,24 @@ int main (int argc, char **argv)
 		{
 			use_algorithm = atoi(optarg);
 		}
+		else if (strcmp(optname, "-e") == 0)
+		{
+			use_mincut = atoi(optarg);
+			if ((use_mincut != MINCUT_ST_PAIRS) && (use_mincut != MINCUT_CACTUS))
+			{
+				cerr << "method for minimum cuts must be 0 or 1" << endl;
+				exit (0);				
+			}
+		}
+		else if (strcmp(optname, "-j") == 0)
+		{
+			num_threads = atoi(optarg);
+			if (num_threads < 1)
+			{
+				cerr << "number of threads must be at least one" << endl;
+				exit (0);				
+			}
+		}
 		else if (strcmp(optname, "-c") == 0)
 		{
 			bClusterGraph = true;
@@ -2054,12 +2225,22 @@ int main (int argc, char **argv)
     	{  
     		bWriteMRP = true; 
 		strcpy( mrp_name, optarg);   		
+    	}
+		else if (strcmp(optname, "-x") == 0) 
+    	{  
+    		bWriteBinaryMRP = true; 
+		strcpy( mrpx_name, optarg);   		
     	}
      	else if (strcmp(optname, "-k") == 0) 
     	{  
     		bWriteNewick = true; 
 			strcpy( nwk_name, optarg);   		
     	}
+     	else if (strcmp(optname, "-z") == 0) 
+    	{  
+    		bWriteCache = true; 
+			strcpy( cache_name, optarg);   		
+    	}
         else if (strcmp(optname, "-v") == 0) 
         { 
         	cout << "Supertree version 0.1" << endl;
@@ -2094,8 +2275,6 @@ int main (int argc, char **argv)
 
 	cout << "Mincut supertree version " << MAJOR_VERSION << "." MINOR_VERSION << "." << MINI_VERSION << endl;
 
-	ifstream f (fname);
-
 	bShowST				= false;
 	bShowSTEmax			= false;
 	bShowAllMinCuts 	= true;
@@ -2103,7 +2282,6 @@ int main (int argc, char **argv)
 	bShowMinCutWeight	= true;
 	bShowVertexSets		= false;
 	bShowRecursion		= false;
-	bShowTStest			= false;
 	bShowConnected		= false;
 	bShowTS				= false;
 	bShowClusters		= false;
@@ -2118,9 +2296,12 @@ int main (int argc, char **argv)
 		bShowMinCutWeight = false;
 	}
 	
+	if (num_threads > 1)
+		pool = new ThreadPool (num_threads);
+
 	Profile<NTree> p;
 
-    if (!p.ReadTrees (f))
+    if (!p.ReadTrees (fname, pool))
 	{
 		cerr << "Failed to read trees, bailing out" << endl;
 		exit(0);
@@ -2143,15 +2324,22 @@ int main (int argc, char **argv)
 		NTree t = p.GetIthTree (i);
 
 		// We need to build clusters using the same labels across
-		// all trees
+		// all trees. Trees read from a profile cache already have them.
 		t.MakeNodeList();
-		for (int j = 0; j < t.GetNumLeaves(); j++)
-			t[j]->SetLabelNumber (p.GetIndexOfLabel (t[j]->GetLabel()) + 1);
+		if (!p.HasLabelNumbers())
+		{
+			for (int j = 0; j < t.GetNumLeaves(); j++)
+				t[j]->SetLabelNumber (p.GetIndexOfLabel (t[j]->GetLabel()) + 1);
+		}
 		minLeaves = min (minLeaves, t.GetNumLeaves());
 		maxLeaves = max (maxLeaves, t.GetNumLeaves());
 		
 		T.push_back (t);
 	}
+
+	// Profile cache
+	if (bWriteCache)
+		WriteProfileCache (cache_name, T, p);
 	
 	// k-cluster graph
 	if (bClusterGraph)
@@ -2161,14 +2349,30 @@ int main (int argc, char **argv)
 	MakeCOGraph (T, p);
 	
 	// MRP matrix
-	if (bWriteMRP)
+	if (bWriteMRP || bWriteBinaryMRP)
 	{
-		ofstream mrpfile (mrp_name);
-		WriteMRP (mrpfile, T, p);
-		mrpfile.close ();
-		cout << "MRP file written to \"" << mrp_name << "\"" << endl;
+		vector<FlatTree> flat (T.size());
+		for (int i = 0; i < T.size(); i++)
+			flat[i].Assign (T[i]);
+		if (bWriteMRP)
+		{
+			ofstream mrpfile (mrp_name);
+			WriteMRP (mrpfile, flat, p);
+			mrpfile.close ();
+			cout << "MRP file written to \"" << mrp_name << "\"" << endl;
+		}
+		if (bWriteBinaryMRP)
+		{
+			if (!WriteBinaryMRP (mrpx_name, flat, p.GetLabels()))
+			{
+				cerr << "Failed to write binary MRP file \"" << mrpx_name << "\"" << endl;
+				exit (0);
+			}
+			cout << "Binary MRP file written to \"" << mrpx_name << "\"" << endl;
+		}
 		return 0;	
 	}
+
 	
 
 
@@ -2219,7 +2423,16 @@ int main (int argc, char **argv)
     superTree.PushNode ();
     superTree.SetInternalLabels (true);
 
-	MinCutSupertree (T, p);
+	// The steps of a parallel run are output at the end, so verbose output and
+	// graphs written at each step need the serial recursion
+	if ((pool != NULL) && !bVerbose && !bSaveST && !bSaveSTEmax && !bWriteTS)
+	{
+		MinCutStep step;
+		MinCutSupertree (T, p, superTree, &step);
+		ReportSteps (&step);
+	}
+	else
+		MinCutSupertree (T, p, superTree);
 
     superTree.PopNode ();
     
@@ -2362,87 +2575,47 @@ int main (int argc, char **argv)
 			cout << "-------------------------------------------------------------------------------" << endl;
 		}
 			
-		for (int i = 0; i < p.GetNumTrees(); i++)
+		// Each input tree is compared with the supertree independently, so
+		// with more than one thread the comparisons are tasks in a pool. The
+		// results are printed in the order of the trees, and the average fit
+		// is summed in that order, so the output is the same as a serial run.
+		vector<TreeFit> fits (p.GetNumTrees());
+		if (pool != NULL)
 		{
-			// We are comparing each input tree with the subtree induced in the supertree
-			// by the set of leaves in the input tree. This is destructive so we make a 
-			// copy of the supertree.
-			NTree t1 (superTree);
-			// Get ith input tree
-			NTree t2 = p.GetIthTree (i);
-			
-			t1.MakeNodeList();
-			t2.MakeNodeList();
-			
-			
-			// We need to prune excess leaves from supertree, and ensure that leaves in the pruned
-			// supertree have their LeafNumber field in the range 1...n so the triplet comparison
-			// will work correctly. Note that leaves in t2 are already numbered 1...n
-	        IntegerSet toPrune;
-	        int count = 0;
-	        int j = 0;
-	        while (j < t1.GetNumLeaves())
-	        {
-	        	NodePtr matchingLeaf = t2.GetLeafWithLabel (t1[j]->GetLabel());
-	        	if (matchingLeaf != NULL)
-	            {
-	            	// This leaf is in t1 AND t2. Set the LeafNumber of this leaf
-	            	// in t1 to match that in t2
-	            	count++;
-					t1[j]->SetLeafNumber(matchingLeaf->GetLeafNumber());
-	            }
-	            else
-	            {
-	            	// This leaf is not in t2 so we will prune it from the supertree
-	            	toPrune.insert (j);
-	            }
-	            j++;
-	        }
-
-			// Prune excess leaves from t1
-            IntegerSet::iterator nit = toPrune.begin();
-            IntegerSet::iterator nend = toPrune.end();
-            while (nit != nend)
-            {
-            	t1.RemoveNode (t1[*nit]);
-                delete t1[*nit];
-                nit++;
-            }
-
-			// Build clusters in the two trees, and rebuild node list so we
-			// can look up leaves
-   			t1.BuildLeafClusters();
-   			t2.BuildLeafClusters();
-			t1.MakeNodeList();
-			t2.MakeNodeList();
-				
-			QTValues Q;
-			CompareTriplets (t1, t2, Q);
-			SummaryStats (Q);
+			TaskGroup group;
+			for (int i = 0; i < p.GetNumTrees(); i++)
+			{
+				TreeFit *fit = &fits[i];
+				pool->Submit (group, [fit, &p, i] { ComputeTreeFit (p, i, *fit); });
+			}
+			pool->Wait (group);
+		}
+		else
+		{
+			for (int i = 0; i < p.GetNumTrees(); i++)
+				ComputeTreeFit (p, i, fits[i]);
+		}
 
-				
-			double different_in_t2 = Q.d + Q.r2;
-			double resolved_in_t2 = Q.d + Q.s + Q.r2;
-			double t2_fit = 1.0 - different_in_t2/resolved_in_t2;
-			
-			
+		for (int i = 0; i < p.GetNumTrees(); i++)
+		{
+			TreeFit &fit = fits[i];
+			QTValues &Q = fit.Q;
 			if (lots)					
 				cout  << setiosflags (ios::right)
 					<< setw (8) << (i+1)
-					<< setw (8) << t2.GetWeight()
-					<< setw (8) << t2.GetNumLeaves()
+					<< setw (8) << fit.weight
+					<< setw (8) << fit.leaves
 					<< setw (8) << Q.n
 					<< setw (8) << Q.d
 					<< setw (8) << Q.s
 					<< setw (8) << Q.r1
 					<< setw (8) << Q.r2
-					<< setprecision (3) << setw (8) << t2_fit
-					<< "   " << t2.GetName()
+					<< setprecision (3) << setw (8) << fit.fit
+					<< "   " << fit.name
 					<< endl;
 			
-			sum_fit += (double)(t2.GetWeight()) * t2_fit;
-			weighted_count += (double)(t2.GetWeight());
-			
+			sum_fit += (double)(fit.weight) * fit.fit;
+			weighted_count += (double)(fit.weight);
 		}
 		if (lots)
 		{
@@ -2463,7 +2636,18 @@ int main (int argc, char **argv)
 		cout << "Average fit: " << sum_fit/weighted_count << endl;
 		
 	}
+
+	if (pool != NULL)
+	{
+		delete pool;
+		pool = NULL;
+	}
 	
+	if (bVerbose)
+	{
+		cout << endl << "Tree nodes allocated: " << NodePool::GetNumAllocations ()
+			<< " (" << NodePool::GetNumSystemAllocations () << " system allocations)" << endl;
+	}
 	
     return 0;
 }
@@ -0,0 +1,73 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+#include "unionfind.h"
+
+#include <utility>
+
+//------------------------------------------------------------------------------
+void UnionFind::Init (int n)
+{
+	parent.resize (n);
+	for (int i = 0; i < n; i++)
+		parent[i] = i;
+	size.assign (n, 1);
+	num_sets = n;
+}
+
+//------------------------------------------------------------------------------
+void UnionFind::Resize (int n)
+{
+	for (int i = (int)parent.size(); i < n; i++)
+	{
+		parent.push_back (i);
+		size.push_back (1);
+		num_sets++;
+	}
+}
+
+//------------------------------------------------------------------------------
+int UnionFind::Find (int x)
+{
+	while (parent[x] != x)
+	{
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+//------------------------------------------------------------------------------
+bool UnionFind::Union (int x, int y)
+{
+	x = Find (x);
+	y = Find (y);
+	if (x == y)
+		return false;
+	if (size[x] < size[y])
+		std::swap (x, y);
+	parent[y] = x;
+	size[x] += size[y];
+	num_sets--;
+	return true;
+}
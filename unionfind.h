@@ -0,0 +1,78 @@
+/*
+ * Supertree
+ * A program for computing supertrees.
+ * Copyright (C) 2001 Roderic D. M. Page <r.page@bio.gla.ac.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307, USA.
+ */
+
+// $Id$
+
+/**
+ * @file unionfind.h
+ *
+ * Disjoint sets of the integers 0,...,n-1
+ *
+ */
+
+#ifndef UNIONFINDH
+#define UNIONFINDH
+
+#include <vector>
+
+/**
+ * @class UnionFind
+ * A forest of disjoint sets with union by size and path halving, so a
+ * sequence of m calls to Find and Union takes time close to O(m).
+ */
+class UnionFind
+{
+public:
+	UnionFind () { num_sets = 0; };
+	UnionFind (int n) { Init (n); };
+	/**
+	 * @brief Make n sets, {0},...,{n-1}
+	 */
+	void Init (int n);
+	/**
+	 * @brief Add sets {k} for k = GetSize(),...,n-1
+	 */
+	void Resize (int n);
+	/**
+	 * @return the element that represents the set containing x
+	 */
+	int Find (int x);
+	/**
+	 * @brief Join the sets containing x and y
+	 * @return true if x and y were in different sets
+	 */
+	bool Union (int x, int y);
+	/**
+	 * @return the number of sets
+	 */
+	int GetNumSets () const { return num_sets; };
+	/**
+	 * @return the number of elements
+	 */
+	int GetSize () const { return (int)parent.size(); };
+
+protected:
+	std::vector<int>	parent;
+	std::vector<int>	size;
+	int					num_sets;
+};
+
+#endif